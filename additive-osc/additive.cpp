@@ -0,0 +1,240 @@
+//
+// Additive oscillator on a bank of sine resonators.
+//
+// Every partial is a complex phasor (c, s) rotated by (cos kw, sin kw) each
+// sample, 4 multiplies and 2 adds instead of a table lookup per partial.
+// The phasor length is the partial amplitude: once per block the rotation
+// is scaled by the gain that brings it to its target over the block, which
+// both ramps amplitude changes and cancels the rounding drift of the
+// recursion. Partials at or above Nyquist are not rendered.
+//
+
+#include "userosc.h"
+#include "output_stage.h"
+
+// Size of the resonator bank, the partials parameter picks how many of
+// them are used
+#ifndef ADDITIVE_MAX_PARTIALS
+#define ADDITIVE_MAX_PARTIALS (64)
+#endif
+
+typedef struct State {
+    float re[ADDITIVE_MAX_PARTIALS] __attribute__((aligned(16))); //phasors, length is the amplitude
+    float im[ADDITIVE_MAX_PARTIALS] __attribute__((aligned(16)));
+    float amp[ADDITIVE_MAX_PARTIALS] __attribute__((aligned(16))); //target amplitudes
+    float tilt; //spectral slope, partial k is at k^-tilt
+    float even; //level of the even partials
+    uint8_t partials; //partials in use
+    uint8_t active; //partials rendered in the last cycle
+    uint8_t flags;
+} State;
+
+static State s_state;
+
+enum {
+    k_flags_none = 0,
+    k_flag_reset = 1<<0,
+    k_flag_amp_dirty = 1<<1, //tilt, even or partials changed
+};
+
+void OSC_INIT(uint32_t platform, uint32_t api)
+{
+    (void)platform;
+    (void)api;
+    for (int k = 0; k < ADDITIVE_MAX_PARTIALS; k++) {
+        s_state.re[k] = 0.f;
+        s_state.im[k] = 0.f;
+    }
+    s_state.tilt = 1.f;
+    s_state.even = 1.f;
+    s_state.partials = 16;
+    s_state.active = 0;
+    s_state.flags = k_flag_reset | k_flag_amp_dirty;
+}
+
+// Target amplitudes for the current tilt/even/partials, unnormalized
+static void update_amp(void)
+{
+    for (int k = 0; k < s_state.partials; k++) {
+        const float a = fastpow2f(-s_state.tilt * fastlog2f((float)(k + 1)));
+        s_state.amp[k] = (k & 1) ? a * s_state.even : a;
+    }
+}
+
+// Rotate `count` partials from k over the block, adding their sines to y.
+// They are taken 4 at a time so that the recursions, each a chain of
+// dependent multiplies, overlap.
+static inline __attribute__((always_inline))
+void render_partials(float * __restrict y, const uint32_t frames,
+                     float * __restrict re, float * __restrict im,
+                     const float * __restrict rc, const float * __restrict rs, const uint32_t count)
+{
+    uint32_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        float c0 = re[k], c1 = re[k+1], c2 = re[k+2], c3 = re[k+3];
+        float s0 = im[k], s1 = im[k+1], s2 = im[k+2], s3 = im[k+3];
+        for (uint32_t i = 0; i < frames; i++) {
+            y[i] += (s0 + s1) + (s2 + s3);
+            const float t0 = c0 * rc[k] - s0 * rs[k];
+            const float t1 = c1 * rc[k+1] - s1 * rs[k+1];
+            const float t2 = c2 * rc[k+2] - s2 * rs[k+2];
+            const float t3 = c3 * rc[k+3] - s3 * rs[k+3];
+            s0 = s0 * rc[k] + c0 * rs[k];
+            s1 = s1 * rc[k+1] + c1 * rs[k+1];
+            s2 = s2 * rc[k+2] + c2 * rs[k+2];
+            s3 = s3 * rc[k+3] + c3 * rs[k+3];
+            c0 = t0; c1 = t1; c2 = t2; c3 = t3;
+        }
+        re[k] = c0; re[k+1] = c1; re[k+2] = c2; re[k+3] = c3;
+        im[k] = s0; im[k+1] = s1; im[k+2] = s2; im[k+3] = s3;
+    }
+    for (; k < count; k++) {
+        float c = re[k];
+        float s = im[k];
+        for (uint32_t i = 0; i < frames; i++) {
+            y[i] += s;
+            const float t = c * rc[k] - s * rs[k];
+            s = s * rc[k] + c * rs[k];
+            c = t;
+        }
+        re[k] = c;
+        im[k] = s;
+    }
+}
+
+void OSC_CYCLE(const user_osc_param_t * const params,
+               int32_t *yn,
+               const uint32_t frames)
+{
+    const uint8_t flags = s_state.flags;
+    s_state.flags = k_flags_none;
+
+    if (flags & k_flag_amp_dirty) {
+        update_amp();
+    }
+
+    const float w0 = osc_w0f_for_note((params->pitch)>>8, params->pitch & 0xFF);
+
+    // Partials from 0.45 to 0.5 cycles per sample are faded out, the ones
+    // above are skipped and restart from phase 0 when they come back
+    uint32_t active = (uint32_t)(0.5f / w0);
+    if (active * w0 >= 0.5f) {
+        active--;
+    }
+    if (active > s_state.partials) {
+        active = s_state.partials;
+    }
+    for (uint32_t k = active; k < s_state.active; k++) {
+        s_state.re[k] = 0.f;
+        s_state.im[k] = 0.f;
+    }
+    s_state.active = active;
+
+    if (flags & k_flag_reset) {
+        for (uint32_t k = 0; k < active; k++) {
+            s_state.re[k] = 0.f;
+            s_state.im[k] = 0.f;
+        }
+    }
+
+    // Rotation of the fundamental, brought back to unit length as the
+    // table lookups are only accurate to about 1e-4
+    float rc1 = osc_cosf(w0);
+    float rs1 = osc_sinf(w0);
+    const float norm = 1.5f - 0.5f * (rc1 * rc1 + rs1 * rs1);
+    rc1 *= norm;
+    rs1 *= norm;
+
+    const float frames_recip = 1.f / frames;
+    float rc[ADDITIVE_MAX_PARTIALS] __attribute__((aligned(16)));
+    float rs[ADDITIVE_MAX_PARTIALS] __attribute__((aligned(16)));
+    float rck = rc1;
+    float rsk = rs1;
+    float power = 0.f;
+    float peak = 0.f;
+    for (uint32_t k = 0; k < active; k++) {
+        float a = s_state.amp[k];
+        const float fk = (k + 1) * w0;
+        if (fk > 0.45f) {
+            a *= (0.5f - fk) * 20.f;
+        }
+        power += a * a;
+        peak += a;
+
+        // Gain per sample that takes the phasor length to a over the
+        // block. A silent partial starts at phase 0 with its full length.
+        float g = 1.f;
+        const float m2 = s_state.re[k] * s_state.re[k] + s_state.im[k] * s_state.im[k];
+        if (m2 < 1e-12f) {
+            s_state.re[k] = a;
+            s_state.im[k] = 0.f;
+        } else {
+            float l = fastlog2f(a + 1e-9f) - 0.5f * fastlog2f(m2);
+            l = (l < -16.f) ? -16.f : (l > 16.f) ? 16.f : l;
+            g = fastpow2f(l * frames_recip);
+        }
+        rc[k] = rck * g;
+        rs[k] = rsk * g;
+
+        // Next harmonic: (rck, rsk) * (rc1, rs1)
+        const float t = rck * rc1 - rsk * rs1;
+        rsk = rsk * rc1 + rck * rs1;
+        rck = t;
+    }
+    // Constant RMS whatever the tilt and partial count, unless the sum
+    // could then reach full scale: the softclip would add partials above
+    // Nyquist
+    float gain = (power > 0.f) ? 0.5f / sqrtf(power) : 0.f;
+    if (gain * peak > 1.f) {
+        gain = 1.f / peak;
+    }
+
+    float buf[k_output_block] __attribute__((aligned(16)));
+    q31_t * __restrict y = (q31_t *)yn;
+    for (uint32_t done = 0; done < frames; done += k_output_block) {
+        const uint32_t n = (frames - done < k_output_block) ? frames - done : k_output_block;
+        for (uint32_t i = 0; i < n; i++) {
+            buf[i] = 0.f;
+        }
+        render_partials(buf, n, s_state.re, s_state.im, rc, rs, active);
+        output_softclip_q31(y + done, buf, n, gain);
+    }
+}
+
+void OSC_NOTEON(const user_osc_param_t * const params)
+{
+    (void)params;
+    s_state.flags |= k_flag_reset;
+}
+
+void OSC_NOTEOFF(const user_osc_param_t * const params)
+{
+    (void)params;
+}
+
+void OSC_PARAM(uint16_t index, uint16_t value)
+{
+    const float valf = param_val_to_f32(value);
+    switch (index) {
+        case k_user_osc_param_id1: //Partials
+            s_state.partials = (value < 1) ? 1 : (value > ADDITIVE_MAX_PARTIALS) ? ADDITIVE_MAX_PARTIALS : value;
+            s_state.flags |= k_flag_amp_dirty;
+            break;
+        case k_user_osc_param_id2:
+        case k_user_osc_param_id3:
+        case k_user_osc_param_id4:
+        case k_user_osc_param_id5:
+        case k_user_osc_param_id6:
+            break;
+        case k_user_osc_param_shape: //Tilt, flat to steep
+            s_state.tilt = 3.f * valf;
+            s_state.flags |= k_flag_amp_dirty;
+            break;
+        case k_user_osc_param_shiftshape: //Even partials, full to none
+            s_state.even = 1.f - valf;
+            s_state.flags |= k_flag_amp_dirty;
+            break;
+        default:
+            break;
+    }
+}
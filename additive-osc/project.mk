@@ -0,0 +1,17 @@
+# #############################################################################
+# Project Customization
+# #############################################################################
+
+PROJECT = additive-osc
+
+UCSRC =
+
+UCXXSRC = additive.cpp
+
+UINCDIR = ../common
+
+UDEFS =
+
+ULIB = 
+
+ULIBDIR =
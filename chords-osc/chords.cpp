@@ -39,18 +39,65 @@
  */
 
 #include "userosc.h"
+#include "chords.h"
+#include "lanes.h"
+#include "phase_q32.h"
+#include "cycles.h"
+#include "output_stage.h"
+#include "smooth.h"
+
+// CHORDS_PHASE_Q32 selects the phase accumulators at compile time:
+//  0: float phases wrapped with phase -= (uint32_t)phase (default)
+//  1: uint32_t phases scaled by 2^32 that wrap for free and index the
+//     wave tables directly, see phase_q32.h
+#ifndef CHORDS_PHASE_Q32
+#define CHORDS_PHASE_Q32 0
+#endif
+
+// CHORDS_VOICE_MAJOR selects the loop order of the render kernels:
+//  0: sample-major, every voice is advanced for each output sample (default)
+//  1: voice-major, each voice (or group of 4 lanes) runs over the whole
+//     block, accumulating into the output buffer
+#ifndef CHORDS_VOICE_MAJOR
+#define CHORDS_VOICE_MAJOR 0
+#endif
+
+// CHORDS_LFO_RATE is the control rate of the shape LFO in frames: the
+// modulated key or detune is taken this often
+#ifndef CHORDS_LFO_RATE
+#define CHORDS_LFO_RATE 16
+#endif
+
+#if CHORDS_PHASE_Q32
+typedef uint32_t phase_t;
+#else
+typedef float phase_t;
+#endif
 
 typedef struct State {
     float lfo, lfoz;
     uint8_t wave_type;
     uint8_t flags;
     uint8_t key;
+    uint8_t lfo_target; //what the shape LFO moves, k_lfo_key or k_lfo_detune
+    float shape; //key before quantizing, the shape LFO adds to it
     uint8_t extension;
+    uint8_t band_limit; //pick the saw/square tables by pitch
     
     uint8_t notes[4];
-    float w0[12]; //phase increment
-    float phase[12]; //phase
-    float detune;
+    uint16_t pitch; //pitch, key and detune the phase increments were computed for
+    uint8_t w0_key;
+    float w0_detune;
+    float w0[12] __attribute__((aligned(16))); //phase increment
+    phase_t phase[12] __attribute__((aligned(16))); //phase
+    Smooth detune; //follows the parameter over SMOOTH_FRAMES
+    uint8_t stride; //voices per rendered voice, 0 before the first cycle
+    uint16_t fade_left; //frames of the layout crossfade still to go
+    float fade_gain[12] __attribute__((aligned(16))); //voice gains during the crossfade
+    uint8_t level; //governor level, unison copies are halved this many times
+    uint8_t hold; //cycles before the governor may change level again
+    float cost; //smoothed cycles per frame of OSC_CYCLE
+    chords_stats_t stats;
 } State;
 
 const int extensions[12][4] = {
@@ -68,175 +115,749 @@ const int extensions[12][4] = {
     {0, 6, 3, 10} // vii^0
 };
 
+// Copies of each note per extension, identical when detune is 0
+const uint8_t unison[5] = {12, 6, 4, 3, 3};
+
+// Governor levels per extension, until a single copy per note is left
+const uint8_t levels[5] = {3, 2, 2, 1, 1};
+
 enum {
     k_flags_none = 0,
     k_flag_reset = 1<<0, //it's just 1
+    k_flag_w0_dirty = 1<<1, //key or extension changed
+};
+
+enum {
+    k_lfo_key = 0,
+    k_lfo_detune,
+    k_num_lfo_targets,
 };
 
 static State s_state; //Init a state variable
 
+// Cycles per frame, 0 disables the governor. Kept across OSC_INIT.
+static uint32_t s_budget = CHORDS_BUDGET;
+
 void OSC_INIT(uint32_t platform, uint32_t api)
 {
     //Default values
     for (int i = 0; i < 12; i++) {
         s_state.w0[i] = 0.f;
-        s_state.phase[i] = 0.f;
+        s_state.phase[i] = 0;
     }
     s_state.wave_type = 0.f;
     s_state.key = 0;
+    s_state.shape = 0.f;
+    smooth_init(s_state.detune, 0.f);
+    s_state.lfo_target = k_lfo_key;
+    s_state.band_limit = 0;
+    s_state.flags = k_flag_w0_dirty;
+    s_state.stats.w0_cache_hits = 0;
+    s_state.stats.w0_cache_misses = 0;
+    s_state.stats.active_voices = 12;
+    s_state.stride = 0;
+    s_state.fade_left = 0;
+    s_state.level = 0;
+    s_state.hold = 0;
+    s_state.cost = 0.f;
+    s_state.stats.governor_level = 0;
+    s_state.stats.cycles_per_frame = 0;
+    if (s_budget) {
+        cycles_init();
+    }
 }
 
-void OSC_CYCLE(const user_osc_param_t * const params,
-               int32_t *yn,
-               const uint32_t frames)
+const chords_stats_t * chords_stats(void)
 {
-    for (int i = 0; i < 4; i++) {
-        s_state.notes[i] = extensions[(((params->pitch)>>8) + s_state.key) % 12][i];
+    return &s_state.stats;
+}
+
+void chords_set_budget(uint32_t cycles_per_frame)
+{
+    s_budget = cycles_per_frame;
+    if (cycles_per_frame) {
+        cycles_init();
+    } else {
+        s_state.level = 0;
     }
-    // Reset flags
-    const uint8_t flags = s_state.flags;
-    s_state.flags = k_flags_none;
+}
+
+// Recompute the phase increments of all 12 voices for a key and detune,
+// which the shape LFO may have moved away from the parameters
+static void update_w0(const uint16_t pitch, const uint8_t key, const float detune)
+{
 
-    float w0[12];
-    float phase[12];
+    for (int i = 0; i < 4; i++) {
+        s_state.notes[i] = extensions[((pitch>>8) + key) % 12][i];
+    }
     switch (s_state.extension) {
         case 0:
-            w0[0] = s_state.w0[0] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune);
-            w0[1] = s_state.w0[1] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune * 0.8f);
-            w0[2] = s_state.w0[2] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune * 0.6f);
-            w0[3] = s_state.w0[3] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune * 0.4f);
-            w0[4] = s_state.w0[4] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune * 0.2f);
-            w0[5] = s_state.w0[5] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune * 0.1f);
-            w0[6] = s_state.w0[6] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune * 0.1f);
-            w0[7] = s_state.w0[7] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune * 0.2f);
-            w0[8] = s_state.w0[8] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune * 0.4f);
-            w0[9] = s_state.w0[9] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune * 0.6f);
-            w0[10] = s_state.w0[10] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune * 0.8f);
-            w0[11] = s_state.w0[11] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune);
+            s_state.w0[0] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune);
+            s_state.w0[1] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune * 0.8f);
+            s_state.w0[2] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune * 0.6f);
+            s_state.w0[3] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune * 0.4f);
+            s_state.w0[4] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune * 0.2f);
+            s_state.w0[5] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune * 0.1f);
+            s_state.w0[6] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune * 0.1f);
+            s_state.w0[7] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune * 0.2f);
+            s_state.w0[8] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune * 0.4f);
+            s_state.w0[9] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune * 0.6f);
+            s_state.w0[10] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune * 0.8f);
+            s_state.w0[11] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune);
             break;
         case 1:
-            w0[0] = s_state.w0[0] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune);
-            w0[1] = s_state.w0[1] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune * 0.6f);
-            w0[2] = s_state.w0[2] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune * 0.3f);
-            w0[3] = s_state.w0[3] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune * 0.3f);
-            w0[4] = s_state.w0[4] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune * 0.6f);
-            w0[5] = s_state.w0[5] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune);
-            w0[6] = s_state.w0[6] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) + s_state.detune);
-            w0[7] = s_state.w0[7] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) + s_state.detune * 0.6f);
-            w0[8] = s_state.w0[8] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) + s_state.detune * 0.3f);
-            w0[9] = s_state.w0[9] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) - s_state.detune * 0.3f);
-            w0[10] = s_state.w0[10] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) - s_state.detune * 0.6f);
-            w0[11] = s_state.w0[11] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) - s_state.detune);
+            s_state.w0[0] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune);
+            s_state.w0[1] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune * 0.6f);
+            s_state.w0[2] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune * 0.3f);
+            s_state.w0[3] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune * 0.3f);
+            s_state.w0[4] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune * 0.6f);
+            s_state.w0[5] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune);
+            s_state.w0[6] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) + detune);
+            s_state.w0[7] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) + detune * 0.6f);
+            s_state.w0[8] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) + detune * 0.3f);
+            s_state.w0[9] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) - detune * 0.3f);
+            s_state.w0[10] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) - detune * 0.6f);
+            s_state.w0[11] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) - detune);
             break;
         case 2:
-            w0[0] = s_state.w0[0] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune);
-            w0[1] = s_state.w0[1] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune * 0.5f);
-            w0[2] = s_state.w0[2] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune * 0.5f);
-            w0[3] = s_state.w0[3] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune);
-            w0[4] = s_state.w0[4] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) + s_state.detune);
-            w0[5] = s_state.w0[5] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) + s_state.detune * 0.5f);
-            w0[6] = s_state.w0[6] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) - s_state.detune * 0.5f);
-            w0[7] = s_state.w0[7] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) - s_state.detune);
-            w0[8] = s_state.w0[8] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[2], (params->pitch & 0xFF) + s_state.detune);
-            w0[9] = s_state.w0[9] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[2], (params->pitch & 0xFF) + s_state.detune * 0.5f);
-            w0[10] = s_state.w0[10] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[2], (params->pitch & 0xFF) - s_state.detune * 0.5f);
-            w0[11] = s_state.w0[11] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[2], (params->pitch & 0xFF) - s_state.detune);
+            s_state.w0[0] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune);
+            s_state.w0[1] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune * 0.5f);
+            s_state.w0[2] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune * 0.5f);
+            s_state.w0[3] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune);
+            s_state.w0[4] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) + detune);
+            s_state.w0[5] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) + detune * 0.5f);
+            s_state.w0[6] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) - detune * 0.5f);
+            s_state.w0[7] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) - detune);
+            s_state.w0[8] = osc_w0f_for_note((pitch>>8) + s_state.notes[2], (pitch & 0xFF) + detune);
+            s_state.w0[9] = osc_w0f_for_note((pitch>>8) + s_state.notes[2], (pitch & 0xFF) + detune * 0.5f);
+            s_state.w0[10] = osc_w0f_for_note((pitch>>8) + s_state.notes[2], (pitch & 0xFF) - detune * 0.5f);
+            s_state.w0[11] = osc_w0f_for_note((pitch>>8) + s_state.notes[2], (pitch & 0xFF) - detune);
             break;
         case 3:
         case 4:
-            w0[0] = s_state.w0[0] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) + s_state.detune);
-            w0[1] = s_state.w0[1] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF));
-            w0[2] = s_state.w0[2] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[0], (params->pitch & 0xFF) - s_state.detune);
-            w0[3] = s_state.w0[3] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) + s_state.detune);
-            w0[4] = s_state.w0[4] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF));
-            w0[5] = s_state.w0[5] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[1], (params->pitch & 0xFF) - s_state.detune);
-            w0[6] = s_state.w0[6] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[2], (params->pitch & 0xFF) + s_state.detune);
-            w0[7] = s_state.w0[7] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[2], (params->pitch & 0xFF));
-            w0[8] = s_state.w0[8] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[2], (params->pitch & 0xFF) - s_state.detune);
-            w0[9] = s_state.w0[9] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[3], (params->pitch & 0xFF) + s_state.detune);
-            w0[10] = s_state.w0[10] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[3], (params->pitch & 0xFF));
-            w0[11] = s_state.w0[11] = osc_w0f_for_note(((params->pitch)>>8) + s_state.notes[3], (params->pitch & 0xFF) - s_state.detune);
+            s_state.w0[0] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) + detune);
+            s_state.w0[1] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF));
+            s_state.w0[2] = osc_w0f_for_note((pitch>>8) + s_state.notes[0], (pitch & 0xFF) - detune);
+            s_state.w0[3] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) + detune);
+            s_state.w0[4] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF));
+            s_state.w0[5] = osc_w0f_for_note((pitch>>8) + s_state.notes[1], (pitch & 0xFF) - detune);
+            s_state.w0[6] = osc_w0f_for_note((pitch>>8) + s_state.notes[2], (pitch & 0xFF) + detune);
+            s_state.w0[7] = osc_w0f_for_note((pitch>>8) + s_state.notes[2], (pitch & 0xFF));
+            s_state.w0[8] = osc_w0f_for_note((pitch>>8) + s_state.notes[2], (pitch & 0xFF) - detune);
+            s_state.w0[9] = osc_w0f_for_note((pitch>>8) + s_state.notes[3], (pitch & 0xFF) + detune);
+            s_state.w0[10] = osc_w0f_for_note((pitch>>8) + s_state.notes[3], (pitch & 0xFF));
+            s_state.w0[11] = osc_w0f_for_note((pitch>>8) + s_state.notes[3], (pitch & 0xFF) - detune);
             break;
     }
-    
+}
+
+enum {
+    k_wave_saw = 0,
+    k_wave_square,
+    k_wave_sine,
+};
+
+// table is the band-limited table index of the voice, unused by sine
+template <int wave>
+static inline __attribute__((always_inline)) float wavef(const float phase, const uint8_t table)
+{
+    switch (wave) {
+        case k_wave_saw:
+            return osc_bl_sawf(phase, table);
+        case k_wave_square:
+            return osc_bl_sqrf(phase, table);
+        default:
+            return osc_sinf(phase);
+    }
+}
+
+template <int wave>
+static inline __attribute__((always_inline)) float wavef(const uint32_t phase, const uint8_t table)
+{
+    switch (wave) {
+        case k_wave_saw:
+            return phase_q32_bl_sawf(phase, table);
+        case k_wave_square:
+            return phase_q32_bl_sqrf(phase, table);
+        default:
+            return phase_q32_sinf(phase);
+    }
+}
+
+static inline __attribute__((always_inline)) void step(float &phase, const float w0)
+{
+    phase += w0;
+    phase -= (uint32_t)phase;
+}
+
+static inline __attribute__((always_inline)) void step(uint32_t &phase, const uint32_t w0)
+{
+    phase += w0;
+}
+
+#if CHORDS_LANES
+// offset holds the band-limited table offset of each lane
+template <int wave>
+static inline __attribute__((always_inline)) lanes_f lanes_wavef(const lanes_f phase, const uint32_t *offset)
+{
+    switch (wave) {
+        case k_wave_saw:
+            return lanes_bl_sawf(phase, offset);
+        case k_wave_square:
+            return lanes_bl_sqrf(phase, offset);
+        default:
+            return lanes_sinf(phase);
+    }
+}
+
+template <int wave>
+static inline __attribute__((always_inline)) lanes_f lanes_wavef(const lanes_u phase, const uint32_t *offset)
+{
+    switch (wave) {
+        case k_wave_saw:
+            return lanes_q32_bl_sawf(phase, offset);
+        case k_wave_square:
+            return lanes_q32_bl_sqrf(phase, offset);
+        default:
+            return lanes_q32_sinf(phase);
+    }
+}
+
+#if CHORDS_PHASE_Q32
+typedef lanes_u lanes_phase;
+static inline __attribute__((always_inline)) lanes_u lanes_load_phase(const uint32_t *p) { return lanes_load_u(p); }
+static inline __attribute__((always_inline)) void lanes_store_phase(uint32_t *p, const lanes_u a) { lanes_store_u(p, a); }
+static inline __attribute__((always_inline)) lanes_u lanes_step(const lanes_u p, const lanes_u w0) { return lanes_add_u(p, w0); }
+#else
+typedef lanes_f lanes_phase;
+static inline __attribute__((always_inline)) lanes_f lanes_load_phase(const float *p) { return lanes_load(p); }
+static inline __attribute__((always_inline)) void lanes_store_phase(float *p, const lanes_f a) { lanes_store(p, a); }
+static inline __attribute__((always_inline)) lanes_f lanes_step(const lanes_f p, const lanes_f w0) { return lanes_wrapf(lanes_add(p, w0)); }
+#endif
+#endif
+
+// Render the sum of the first `voices` voices into a float block of at
+// most k_output_block frames, the output stage does the rest. The wave and
+// voice count are template arguments so each variant gets its own
+// branch-free loop. table holds the band-limited table of each voice.
+template <int wave, int voices>
+static inline __attribute__((always_inline))
+void render_sample_major(phase_t * __restrict phase, const phase_t * __restrict w0,
+                         const uint8_t * __restrict table,
+                         float * __restrict y, const uint32_t frames)
+{
+    const float * y_e = y + frames; // pointer to end of buffer
+
+#if CHORDS_LANES
+    // Voices are kept in groups of 4 lanes, the unused lanes of the last
+    // group are masked out of the sum
+    enum { k_groups = (voices + 3) / 4 };
+    static const float masks[4][4] __attribute__((aligned(16))) = {
+        {1.f, 1.f, 1.f, 1.f}, {1.f, 0.f, 0.f, 0.f}, {1.f, 1.f, 0.f, 0.f}, {1.f, 1.f, 1.f, 0.f}
+    };
+    const lanes_f mask = lanes_load(masks[voices & 3]);
+    lanes_phase w0_g[k_groups];
+    lanes_phase phase_g[k_groups];
+    uint32_t offset[4*k_groups];
+    for (int g = 0; g < k_groups; g++) {
+        w0_g[g] = lanes_load_phase(&w0[4*g]);
+        phase_g[g] = lanes_load_phase(&phase[4*g]);
+    }
+    for (int i = 0; i < 4*k_groups; i++) {
+        offset[i] = table[i] * ((wave == k_wave_square) ? k_wt_sqr_lut_size : k_wt_saw_lut_size);
+    }
+
+    for (; y < y_e; ) {
+        lanes_f sum = lanes_dup(0.f);
+        for (int g = 0; g < k_groups; g++) {
+            lanes_f x = lanes_wavef<wave>(phase_g[g], &offset[4*g]);
+            if ((voices & 3) && g == k_groups - 1) {
+                x = lanes_mul(x, mask);
+            }
+            sum = g ? lanes_add(sum, x) : x;
+        }
+        *(y++) = lanes_hsum(sum);
+        for (int g = 0; g < k_groups; g++) {
+            phase_g[g] = lanes_step(phase_g[g], w0_g[g]);
+        }
+    }
+
+    for (int g = 0; g < k_groups; g++) {
+        lanes_store_phase(&phase[4*g], phase_g[g]);
+    }
+#else
+    for (; y < y_e; ) {
+        float sum = 0.f;
+        for (int i = 0; i < voices; i++) {
+            sum += wavef<wave>(phase[i], table[i]);
+        }
+        *(y++) = sum;
+        for (int i = 0; i < voices; i++) {
+            step(phase[i], w0[i]);
+        }
+    }
+#endif
+}
+
+// Same as render_sample_major with the loops swapped. Sums are formed in
+// the same order, so the output is identical.
+template <int wave, int voices>
+static inline __attribute__((always_inline))
+void render_voice_major(phase_t * __restrict phase, const phase_t * __restrict w0,
+                        const uint8_t * __restrict table,
+                        float * __restrict y, const uint32_t frames)
+{
+#if CHORDS_LANES
+    enum { k_groups = (voices + 3) / 4 };
+    static const float masks[4][4] __attribute__((aligned(16))) = {
+        {1.f, 1.f, 1.f, 1.f}, {1.f, 0.f, 0.f, 0.f}, {1.f, 1.f, 0.f, 0.f}, {1.f, 1.f, 1.f, 0.f}
+    };
+    const lanes_f mask = lanes_load(masks[voices & 3]);
+    uint32_t offset[4*k_groups];
+    for (int i = 0; i < 4*k_groups; i++) {
+        offset[i] = table[i] * ((wave == k_wave_square) ? k_wt_sqr_lut_size : k_wt_saw_lut_size);
+    }
+    lanes_f acc[k_output_block];
+
+    for (int g = 0; g < k_groups; g++) {
+        const lanes_phase w0_g = lanes_load_phase(&w0[4*g]);
+        lanes_phase phase_g = lanes_load_phase(&phase[4*g]);
+        for (uint32_t i = 0; i < frames; i++) {
+            lanes_f x = lanes_wavef<wave>(phase_g, &offset[4*g]);
+            if ((voices & 3) && g == k_groups - 1) {
+                x = lanes_mul(x, mask);
+            }
+            acc[i] = g ? lanes_add(acc[i], x) : x;
+            phase_g = lanes_step(phase_g, w0_g);
+        }
+        lanes_store_phase(&phase[4*g], phase_g);
+    }
+    for (uint32_t i = 0; i < frames; i++) {
+        y[i] = lanes_hsum(acc[i]);
+    }
+#else
+    for (uint32_t i = 0; i < frames; i++) {
+        y[i] = 0.f;
+    }
+    for (int v = 0; v < voices; v++) {
+        const phase_t w = w0[v];
+        const uint8_t t = table[v];
+        phase_t p = phase[v];
+        for (uint32_t i = 0; i < frames; i++) {
+            y[i] += wavef<wave>(p, t);
+            step(p, w);
+        }
+        phase[v] = p;
+    }
+#endif
+}
+
+template <int wave, int voices>
+static void render(phase_t * __restrict phase, const phase_t * __restrict w0,
+                   const uint8_t * __restrict table,
+                   float * __restrict y, const uint32_t frames)
+{
+#if CHORDS_VOICE_MAJOR
+    render_voice_major<wave, voices>(phase, w0, table, y, frames);
+#else
+    render_sample_major<wave, voices>(phase, w0, table, y, frames);
+#endif
+}
+
+typedef void (*render_fptr)(phase_t * __restrict phase, const phase_t * __restrict w0,
+                            const uint8_t * __restrict table,
+                            float * __restrict y, const uint32_t frames);
+
+#define RENDER_WAVES(voices) { \
+    render<k_wave_saw, voices>, \
+    render<k_wave_square, voices>, \
+    render<k_wave_sine, voices>, \
+    render<k_wave_sine, voices>, \
+}
+
+// Indexed by active voices (1, 2, 3, 4, then 6 and 12 in the last rows)
+// then by wave_type, 3 is what the wave parameter gives at 100%
+static const render_fptr s_render[6][4] = {
+    RENDER_WAVES(1),
+    RENDER_WAVES(2),
+    RENDER_WAVES(3),
+    RENDER_WAVES(4),
+    RENDER_WAVES(6),
+    RENDER_WAVES(12),
+};
+
+// Crossfade between two voice layouts: all 12 voices are rendered, each
+// with its own gain stepped by gain_inc every frame. gain is updated so
+// that the ramp carries on over the next call.
+template <int wave>
+static void render_fade(phase_t * __restrict phase, const phase_t * __restrict w0,
+                        const uint8_t * __restrict table, float * __restrict y, const uint32_t frames,
+                        float * __restrict gain, const float * __restrict gain_inc)
+{
+    const float * y_e = y + frames; // pointer to end of buffer
+
+#if CHORDS_LANES
+    lanes_phase w0_g[3];
+    lanes_phase phase_g[3];
+    lanes_f gain_g[3];
+    lanes_f gain_inc_g[3];
+    uint32_t offset[12];
     for (int i = 0; i < 12; i++) {
-        phase[i] = (flags & k_flag_reset) ? 0.f : s_state.phase[i];
+        offset[i] = table[i] * ((wave == k_wave_square) ? k_wt_sqr_lut_size : k_wt_saw_lut_size);
+    }
+    for (int g = 0; g < 3; g++) {
+        w0_g[g] = lanes_load_phase(&w0[4*g]);
+        phase_g[g] = lanes_load_phase(&phase[4*g]);
+        gain_g[g] = lanes_load(&gain[4*g]);
+        gain_inc_g[g] = lanes_load(&gain_inc[4*g]);
+    }
+
+    for (; y < y_e; ) {
+        lanes_f sum = lanes_mul(lanes_wavef<wave>(phase_g[0], &offset[0]), gain_g[0]);
+        for (int g = 1; g < 3; g++) {
+            sum = lanes_add(sum, lanes_mul(lanes_wavef<wave>(phase_g[g], &offset[4*g]), gain_g[g]));
+        }
+        *(y++) = lanes_hsum(sum);
+        for (int g = 0; g < 3; g++) {
+            phase_g[g] = lanes_step(phase_g[g], w0_g[g]);
+            gain_g[g] = lanes_add(gain_g[g], gain_inc_g[g]);
+        }
+    }
+
+    for (int g = 0; g < 3; g++) {
+        lanes_store_phase(&phase[4*g], phase_g[g]);
+        lanes_store(&gain[4*g], gain_g[g]);
+    }
+#else
+    for (; y < y_e; ) {
+        float sum = 0.f;
+        for (int i = 0; i < 12; i++) {
+            sum += gain[i] * wavef<wave>(phase[i], table[i]);
+        }
+        *(y++) = sum;
+        for (int i = 0; i < 12; i++) {
+            step(phase[i], w0[i]);
+            gain[i] += gain_inc[i];
+        }
+    }
+#endif
+}
+
+typedef void (*render_fade_fptr)(phase_t * __restrict phase, const phase_t * __restrict w0,
+                                 const uint8_t * __restrict table, float * __restrict y, const uint32_t frames,
+                                 float * __restrict gain, const float * __restrict gain_inc);
+
+static const render_fade_fptr s_render_fade[4] = {
+    render_fade<k_wave_saw>,
+    render_fade<k_wave_square>,
+    render_fade<k_wave_sine>,
+    render_fade<k_wave_sine>,
+};
+
+// Band-limited table for a saw or square voice: the richest one that does
+// not alias at w0, picked from the fractional index osc_bl_*_idx gives for
+// the voice's note
+static uint8_t bl_table(const float w0, const uint8_t wave)
+{
+    const float note = 69.f + 12.f * fastlog2f(w0 * (k_samplerate / 440.f));
+    const float idx = (wave == k_wave_square) ? osc_bl_sqr_idx(note) : osc_bl_saw_idx(note);
+    const uint32_t i = (uint32_t)idx;
+    return clipmaxu32(i + (idx > i), k_wt_saw_notes_cnt - 1);
+}
+
+// Length of the crossfade between two voice layouts, about 5 ms
+#define k_fade_frames (256)
+
+// Output gain of each of the 12 voices when one voice out of `stride` is
+// rendered for all of them
+static void layout_gains(float * gain, const uint32_t stride)
+{
+    const uint32_t offset = (stride - 1) / 2;
+    for (uint32_t i = 0; i < 12; i++) {
+        gain[i] = (i % stride == offset) ? 0.1f * stride : 0.f;
+    }
+}
+
+// Track the cost of OSC_CYCLE against the budget. Over it, the unison
+// copies of each note are halved, and they are brought back once the cost
+// at the lower level would fit again with some headroom. Each change is
+// followed by a hold period to let the average settle.
+static void governor(const uint32_t cycles, const uint32_t frames)
+{
+    enum { k_hold = 16 };
+    s_state.cost += 0.125f * ((float)cycles / frames - s_state.cost);
+    s_state.stats.cycles_per_frame = (uint32_t)s_state.cost;
+    if (s_state.hold) {
+        s_state.hold--;
+        return;
+    }
+    const float budget = (float)s_budget;
+    if (s_state.cost > budget && s_state.level < levels[s_state.extension]) {
+        s_state.level++;
+        s_state.cost *= 0.5f;
+        s_state.hold = k_hold;
+    } else if (s_state.level > 0 && 2.f * s_state.cost < 0.8f * budget) {
+        s_state.level--;
+        s_state.cost *= 2.f;
+        s_state.hold = k_hold;
+    }
+}
+
+// Key and detune with the shape LFO at l added to one of them, d is the
+// smoothed detune parameter at that point
+static inline void lfo_modulate(const float l, const float d, uint8_t &key, float &detune)
+{
+    key = s_state.key;
+    detune = d;
+    if (l == 0.f) {
+        return;
+    } else if (s_state.lfo_target == k_lfo_key) {
+        key = (uint8_t)(11.f * clip01f(s_state.shape + l));
+    } else {
+        detune = 1023.f * clip01f(detune * (1.f / 1023.f) + l);
+    }
+}
+
+// Increments of the rendered voices, and their band-limited tables
+static void gather_w0(phase_t *w0, uint8_t *table, const uint32_t first, const uint32_t spacing,
+                      const uint32_t voices, const uint8_t wave)
+{
+    for (uint32_t i = 0; i < voices; i++) {
+#if CHORDS_PHASE_Q32
+        w0[i] = phase_q32_from_f32(s_state.w0[first + i * spacing]);
+#else
+        w0[i] = s_state.w0[first + i * spacing];
+#endif
     }
-    // Get lfo parameters (q31 is a fixed-point 31 bit)
+    // Saw and square read the full band table unless band limiting is on,
+    // then the table follows each voice's pitch
+    if (s_state.band_limit && wave < k_wave_sine) {
+        for (uint32_t i = 0; i < voices; i++) {
+            table[i] = bl_table(s_state.w0[first + i * spacing], wave);
+        }
+    }
+}
+
+// Control point of the LFO within the block: new increments if the
+// modulated key or detune moved
+static void lfo_update(const uint16_t pitch, const float l, const float d, phase_t *w0, uint8_t *table,
+                       const uint32_t first, const uint32_t spacing, const uint32_t voices, const uint8_t wave)
+{
+    uint8_t key;
+    float detune;
+    lfo_modulate(l, d, key, detune);
+    if (key != s_state.w0_key || detune != s_state.w0_detune) {
+        update_w0(pitch, key, detune);
+        s_state.w0_key = key;
+        s_state.w0_detune = detune;
+        s_state.stats.w0_cache_misses++;
+        gather_w0(w0, table, first, spacing, voices, wave);
+    }
+}
+
+// Increments of the rendered voices at x between a, at the start of the
+// block, and b, at its end
+static void lerp_w0(phase_t *w0, uint8_t *table, const float *a, const float *b, const float x,
+                    const uint32_t voices, const uint8_t wave)
+{
+    float w[12];
+    for (uint32_t i = 0; i < voices; i++) {
+        w[i] = a[i] + x * (b[i] - a[i]);
+#if CHORDS_PHASE_Q32
+        w0[i] = phase_q32_from_f32(w[i]);
+#else
+        w0[i] = w[i];
+#endif
+    }
+    if (s_state.band_limit && wave < k_wave_sine) {
+        for (uint32_t i = 0; i < voices; i++) {
+            table[i] = bl_table(w[i], wave);
+        }
+    }
+}
+
+void OSC_CYCLE(const user_osc_param_t * const params,
+               int32_t *yn,
+               const uint32_t frames)
+{
+    const uint32_t t0 = s_budget ? cycles_now() : 0;
+
+    // Reset flags
+    const uint8_t flags = s_state.flags;
+    s_state.flags = k_flags_none;
+
+    // The shape LFO comes once per block and is followed from the last
+    // value. Key or detune are taken from it every CHORDS_LFO_RATE frames,
+    // at the middle of each step, and the phases integrate the increments
+    // in between. A still LFO is only looked at once. The detune parameter
+    // ramps to a new value the same way, and is only looked at once when
+    // it has settled. While detune moves and the key stays put over the
+    // block, the increments of the steps are interpolated between the
+    // ones at the start and at the end of the block instead of being
+    // recomputed for each step.
     const float lfo = s_state.lfo = q31_to_f32(params->shape_lfo);
-    // Reset lfo if flag is on, otherwise just get next lfo value
     float lfoz = (flags & k_flag_reset) ? lfo : s_state.lfoz;
-    // LFO increment
     const float lfo_inc = (lfo - lfoz) / frames;
+    float d;
+    const float d_inc = smooth_block(s_state.detune, frames, d);
+    const uint32_t rate = (lfo_inc != 0.f || d_inc != 0.f) ? CHORDS_LFO_RATE : frames;
+    uint8_t key_end;
+    float detune_end;
+    lfo_modulate(lfoz + lfo_inc * frames, d + d_inc * frames, key_end, detune_end);
+    uint8_t key;
+    float detune;
+    lfo_modulate(lfoz, d, key, detune);
+    const bool lerp = rate < frames && key == key_end && detune != detune_end;
+    if (!lerp) {
+        lfo_modulate(lfoz + lfo_inc * (0.5f * rate), d + d_inc * (0.5f * rate), key, detune);
+    }
 
-    // yn = pointer to first buffer position
-    q31_t * __restrict y = (q31_t *)yn; // pointer to current buffer position
-    const q31_t * y_e = y + frames; // pointer to end of buffer
-
-    for (; y < y_e; ) { //Loop to fill buffer (why is it not a while?)
-        float sig;
-        switch (s_state.wave_type) {
-            case 0:
-                sig = osc_softclipf(0.05f,
-                        (osc_sawf(phase[0]) +
-                        osc_sawf(phase[1]) +
-                        osc_sawf(phase[2]) +
-                        osc_sawf(phase[3]) +
-                        osc_sawf(phase[4]) +
-                        osc_sawf(phase[5]) +
-                        osc_sawf(phase[6]) +
-                        osc_sawf(phase[7]) +
-                        osc_sawf(phase[8]) +
-                        osc_sawf(phase[9]) +
-                        osc_sawf(phase[10]) +
-                        osc_sawf(phase[11])) * 0.1f
-                      );
-                break;
-            case 1:
-                sig = osc_softclipf(0.05f,
-                        (osc_sqrf(phase[0]) +
-                        osc_sqrf(phase[1]) +
-                        osc_sqrf(phase[2]) +
-                        osc_sqrf(phase[3]) +
-                        osc_sqrf(phase[4]) +
-                        osc_sqrf(phase[5]) +
-                        osc_sqrf(phase[6]) +
-                        osc_sqrf(phase[7]) +
-                        osc_sqrf(phase[8]) +
-                        osc_sqrf(phase[9]) +
-                        osc_sqrf(phase[10]) +
-                        osc_sqrf(phase[11])) * 0.1f
-                      );
-                break;
-            case 2:
-            case 3:
-                sig = osc_softclipf(0.05f,
-                        (osc_sinf(phase[0]) +
-                        osc_sinf(phase[1]) +
-                        osc_sinf(phase[2]) +
-                        osc_sinf(phase[3]) +
-                        osc_sinf(phase[4]) +
-                        osc_sinf(phase[5]) +
-                        osc_sinf(phase[6]) +
-                        osc_sinf(phase[7]) +
-                        osc_sinf(phase[8]) +
-                        osc_sinf(phase[9]) +
-                        osc_sinf(phase[10]) +
-                        osc_sinf(phase[11])) * 0.1f
-                      );
-                break;
+    // The increments only depend on pitch, key, detune and extension, so
+    // they are kept across cycles while a chord is held
+    if ((flags & k_flag_w0_dirty) || params->pitch != s_state.pitch
+        || key != s_state.w0_key || detune != s_state.w0_detune) {
+        update_w0(params->pitch, key, detune);
+        s_state.pitch = params->pitch;
+        s_state.w0_key = key;
+        s_state.w0_detune = detune;
+        s_state.stats.w0_cache_misses++;
+    } else {
+        s_state.stats.w0_cache_hits++;
+    }
+
+    // With detune at 0 the unison copies of a note are identical, only one
+    // of each is rendered and the sum is scaled by the number of copies.
+    // Otherwise the governor level decides how many copies are kept. The
+    // rendered voices are the ones nearest to the middle of each stride.
+    if (s_state.level > levels[s_state.extension]) {
+        s_state.level = levels[s_state.extension];
+    }
+    const uint32_t copies_max = unison[s_state.extension];
+    const uint32_t copies = (detune == 0.f && detune_end == 0.f) ? 1 : (copies_max >> s_state.level);
+    const uint32_t stride = copies_max / (copies ? copies : 1);
+    const uint32_t offset = (stride - 1) / 2;
+    // A layout change is crossfaded over k_fade_frames rendering all
+    // voices, whatever the block size. A change during a fade starts a new
+    // one from the gains reached so far.
+    if (s_state.stride && stride != s_state.stride) {
+        if (!s_state.fade_left) {
+            layout_gains(s_state.fade_gain, s_state.stride);
         }
-        *(y++) = f32_to_q31(sig);
+        s_state.fade_left = k_fade_frames;
+    }
+    const bool fading = s_state.fade_left != 0;
+    const uint32_t voices = fading ? 12 : 12 / stride;
+    const uint32_t first = fading ? 0 : offset;
+    const uint32_t spacing = fading ? 1 : stride;
+    s_state.stride = stride;
+    s_state.stats.active_voices = voices;
+    s_state.stats.governor_level = s_state.level;
+
+    // Unused slots stay at 0 so that padding lanes read valid phases
+    phase_t w0[12] __attribute__((aligned(16))) = {0};
+    phase_t phase[12] __attribute__((aligned(16))) = {0};
+    const uint8_t wave = s_state.wave_type & 3;
+    uint8_t table[12] __attribute__((aligned(4))) = {0};
+    gather_w0(w0, table, first, spacing, voices, wave);
+    for (uint32_t i = 0; i < voices; i++) {
+        phase[i] = (flags & k_flag_reset) ? 0 : s_state.phase[first + i * spacing];
+    }
+    // The increments at the end of the block are the ones the next block
+    // starts from
+    float w0_a[12];
+    float w0_b[12];
+    const float frames_recip = 1.f / frames;
+    if (lerp) {
+        for (uint32_t i = 0; i < voices; i++) {
+            w0_a[i] = s_state.w0[first + i * spacing];
+        }
+        update_w0(params->pitch, key_end, detune_end);
+        s_state.w0_key = key_end;
+        s_state.w0_detune = detune_end;
+        s_state.stats.w0_cache_misses++;
+        for (uint32_t i = 0; i < voices; i++) {
+            w0_b[i] = s_state.w0[first + i * spacing];
+        }
+    }
+
+    // Wave type and voice count are constant for the block, pick the
+    // kernel once. The sum goes through the output stage k_output_block
+    // frames at a time, and the increments are brought up to date with
+    // the LFO every `rate` frames.
+    float buf[k_output_block] __attribute__((aligned(16)));
+    q31_t * __restrict y = (q31_t *)yn;
+    if (fading) {
+        // The gains ramp for the first nf frames and stay at the new
+        // layout for the rest of the block
+        float * const gain = s_state.fade_gain;
+        float target[12] __attribute__((aligned(16)));
+        float gain_inc[12] __attribute__((aligned(16)));
+        const float still[12] __attribute__((aligned(16))) = {0};
+        layout_gains(target, stride);
+        const uint32_t nf = (frames < s_state.fade_left) ? frames : s_state.fade_left;
+        const float left_recip = 1.f / s_state.fade_left;
         for (int i = 0; i < 12; i++) {
-            phase[i] += w0[i];
-            phase[i] -= (uint32_t)phase[i];
+            gain_inc[i] = (target[i] - gain[i]) * left_recip;
+        }
+        for (uint32_t done = 0; done < frames; done += k_output_block) {
+            const uint32_t n = (frames - done < k_output_block) ? frames - done : k_output_block;
+            for (uint32_t seg = 0; seg < n; seg += rate) {
+                const uint32_t ns = (n - seg < rate) ? n - seg : rate;
+                const uint32_t pos = done + seg;
+                const float t = pos + 0.5f * ns;
+                if (lerp) {
+                    lerp_w0(w0, table, w0_a, w0_b, t * frames_recip, voices, wave);
+                } else if (pos) {
+                    lfo_update(params->pitch, lfoz + lfo_inc * t, d + d_inc * t, w0, table, first, spacing, voices, wave);
+                }
+                const uint32_t nr = (pos >= nf) ? 0 : (nf - pos < ns) ? nf - pos : ns;
+                if (nr) {
+                    s_render_fade[wave](phase, w0, table, buf + seg, nr, gain, gain_inc);
+                    if (pos + nr == nf && nf == s_state.fade_left) {
+                        for (int i = 0; i < 12; i++) {
+                            gain[i] = target[i];
+                        }
+                    }
+                }
+                if (nr < ns) {
+                    s_render_fade[wave](phase, w0, table, buf + seg + nr, ns - nr, gain, still);
+                }
+            }
+            output_softclip_q31(y + done, buf, n, 1.f);
+        }
+        s_state.fade_left -= nf;
+    } else {
+        const uint32_t row = (voices <= 4) ? voices - 1 : (voices == 6) ? 4 : 5;
+        const render_fptr render_block = s_render[row][wave];
+        for (uint32_t done = 0; done < frames; done += k_output_block) {
+            const uint32_t n = (frames - done < k_output_block) ? frames - done : k_output_block;
+            for (uint32_t seg = 0; seg < n; seg += rate) {
+                const uint32_t ns = (n - seg < rate) ? n - seg : rate;
+                const float t = done + seg + 0.5f * ns;
+                if (lerp) {
+                    lerp_w0(w0, table, w0_a, w0_b, t * frames_recip, voices, wave);
+                } else if (done + seg) {
+                    lfo_update(params->pitch, lfoz + lfo_inc * t, d + d_inc * t, w0, table, first, spacing, voices, wave);
+                }
+                render_block(phase, w0, table, buf + seg, ns);
+            }
+            output_softclip_q31(y + done, buf, n, 0.1f * stride);
         }
-        lfoz += lfo_inc;
     }
+    lfoz += lfo_inc * frames;
+
+    // The copies follow the voice that was rendered for them, so they are
+    // in phase when they come back
     for (int i = 0; i < 12; i++) {
-        s_state.phase[i] = phase[i];
+        s_state.phase[i] = phase[i / spacing];
     }
     s_state.lfoz = lfoz;
+
+    // The crossfade renders every voice, its cost does not tell anything
+    // about the current level
+    if (s_budget && !fading) {
+        governor(cycles_now() - t0, frames);
+    }
 }
 
 void OSC_NOTEON(const user_osc_param_t * const params)
@@ -258,21 +879,26 @@ void OSC_PARAM(uint16_t index, uint16_t value)
             s_state.wave_type = (uint8_t)(value / 100.f * 3.f);
             break;
         case k_user_osc_param_id2: //Detune
-            s_state.detune = 1023.f * valf;
+            smooth_set(s_state.detune, 1023.f * valf);
             break;
-        case k_user_osc_param_id3: //Attenuation
+        case k_user_osc_param_id3: //Band limit
+            s_state.band_limit = (value != 0);
             break;
-        case k_user_osc_param_id4:
+        case k_user_osc_param_id4: //Shape LFO target
+            s_state.lfo_target = (value < k_num_lfo_targets) ? value : (uint16_t)k_lfo_key;
             break;
         case k_user_osc_param_id5:
             break;
         case k_user_osc_param_id6:
             break;
         case k_user_osc_param_shape: //Key
+            s_state.shape = valf;
             s_state.key = (uint8_t)(11.f * valf);
+            s_state.flags |= k_flag_w0_dirty;
             break;
         case k_user_osc_param_shiftshape: //Extension
             s_state.extension = (uint8_t)(4.f * valf);
+            s_state.flags |= k_flag_w0_dirty;
             break;
         default:
             break;
@@ -0,0 +1,44 @@
+//
+// Diagnostics exported by the chords oscillator.
+//
+
+#ifndef CHORDS_OSC_CHORDS_H
+#define CHORDS_OSC_CHORDS_H
+
+#include <stdint.h>
+
+// Default cost budget of OSC_CYCLE in cycles per frame. Above it the
+// governor drops unison copies, see governor(). 0, the default, disables
+// the governor and leaves the cycle counter alone. 875 is a quarter of the
+// 3500 cycles available per sample at 168 MHz. Host builds time the hook
+// with the wall clock, so there renders depend on the load of the machine
+// whenever a budget is set.
+#ifndef CHORDS_BUDGET
+#define CHORDS_BUDGET (0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct chords_stats_s {
+    uint32_t w0_cache_hits; //cycles that reused the phase increments
+    uint32_t w0_cache_misses; //cycles that recomputed them
+    uint32_t active_voices; //voices rendered by the last cycle, 12 at most
+    uint32_t governor_level; //unison copies are halved this many times
+    uint32_t cycles_per_frame; //smoothed cost of OSC_CYCLE, 168 MHz cycles
+} chords_stats_t;
+
+// Counters since OSC_INIT and the current voice count and governor state
+const chords_stats_t * chords_stats(void);
+
+// Cost budget of OSC_CYCLE in 168 MHz cycles per frame, CHORDS_BUDGET by
+// default. A nonzero value starts the cycle counter, 0 disables the
+// governor and restores every voice.
+void chords_set_budget(uint32_t cycles_per_frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CHORDS_OSC_CHORDS_H
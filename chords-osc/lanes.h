@@ -0,0 +1,200 @@
+//
+// 4-wide float lanes for the chords voice bank.
+//
+// CHORDS_VOICE_SIMD selects the voice kernel at compile time:
+//  0: scalar, the 12 voices are updated one at a time
+//  1: voices are processed 4 at a time with SSE2 or NEON when the compiler
+//     targets one of them, scalar otherwise (default)
+// The Cortex-M4 FPU has no packed float instructions, so target builds
+// always end up on the scalar kernel.
+//
+
+#ifndef CHORDS_OSC_LANES_H
+#define CHORDS_OSC_LANES_H
+
+#include "userosc.h"
+#include "phase_q32.h"
+
+#ifndef CHORDS_VOICE_SIMD
+#define CHORDS_VOICE_SIMD 1
+#endif
+
+#if CHORDS_VOICE_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#define CHORDS_LANES 1
+
+typedef __m128 lanes_f;
+typedef __m128i lanes_u;
+
+static inline __attribute__((always_inline)) lanes_f lanes_dup(const float x) { return _mm_set1_ps(x); }
+static inline __attribute__((always_inline)) lanes_f lanes_load(const float *p) { return _mm_load_ps(p); }
+static inline __attribute__((always_inline)) void lanes_store(float *p, const lanes_f a) { _mm_store_ps(p, a); }
+static inline __attribute__((always_inline)) void lanes_store_u(uint32_t *p, const lanes_u a) { _mm_store_si128((__m128i *)p, a); }
+static inline __attribute__((always_inline)) lanes_u lanes_load_u(const uint32_t *p) { return _mm_load_si128((const __m128i *)p); }
+static inline __attribute__((always_inline)) lanes_u lanes_add_u(const lanes_u a, const lanes_u b) { return _mm_add_epi32(a, b); }
+static inline __attribute__((always_inline)) lanes_u lanes_shr_u(const lanes_u a, const int n) { return _mm_srli_epi32(a, n); }
+static inline __attribute__((always_inline)) lanes_u lanes_shl_u(const lanes_u a, const int n) { return _mm_slli_epi32(a, n); }
+static inline __attribute__((always_inline)) lanes_f lanes_add(const lanes_f a, const lanes_f b) { return _mm_add_ps(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_sub(const lanes_f a, const lanes_f b) { return _mm_sub_ps(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_mul(const lanes_f a, const lanes_f b) { return _mm_mul_ps(a, b); }
+// Truncating conversions, only used on non-negative values below 2^31
+static inline __attribute__((always_inline)) lanes_u lanes_to_u(const lanes_f a) { return _mm_cvttps_epi32(a); }
+static inline __attribute__((always_inline)) lanes_f lanes_from_u(const lanes_u a) { return _mm_cvtepi32_ps(a); }
+// Flip the sign of the lanes where bit n of u is set
+static inline __attribute__((always_inline)) lanes_f lanes_negate_bit(const lanes_f a, const lanes_u u, const int n) {
+    return _mm_xor_ps(a, _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(u, n), 31)));
+}
+static inline __attribute__((always_inline)) float lanes_hsum(const lanes_f a) {
+    const __m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+#elif CHORDS_VOICE_SIMD && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CHORDS_LANES 1
+
+typedef float32x4_t lanes_f;
+typedef uint32x4_t lanes_u;
+
+static inline __attribute__((always_inline)) lanes_f lanes_dup(const float x) { return vdupq_n_f32(x); }
+static inline __attribute__((always_inline)) lanes_f lanes_load(const float *p) { return vld1q_f32(p); }
+static inline __attribute__((always_inline)) void lanes_store(float *p, const lanes_f a) { vst1q_f32(p, a); }
+static inline __attribute__((always_inline)) void lanes_store_u(uint32_t *p, const lanes_u a) { vst1q_u32(p, a); }
+static inline __attribute__((always_inline)) lanes_u lanes_load_u(const uint32_t *p) { return vld1q_u32(p); }
+static inline __attribute__((always_inline)) lanes_u lanes_add_u(const lanes_u a, const lanes_u b) { return vaddq_u32(a, b); }
+static inline __attribute__((always_inline)) lanes_u lanes_shr_u(const lanes_u a, const int n) { return vshlq_u32(a, vdupq_n_s32(-n)); }
+static inline __attribute__((always_inline)) lanes_u lanes_shl_u(const lanes_u a, const int n) { return vshlq_u32(a, vdupq_n_s32(n)); }
+static inline __attribute__((always_inline)) lanes_f lanes_add(const lanes_f a, const lanes_f b) { return vaddq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_sub(const lanes_f a, const lanes_f b) { return vsubq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_mul(const lanes_f a, const lanes_f b) { return vmulq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_u lanes_to_u(const lanes_f a) { return vcvtq_u32_f32(a); }
+static inline __attribute__((always_inline)) lanes_f lanes_from_u(const lanes_u a) { return vcvtq_f32_u32(a); }
+static inline __attribute__((always_inline)) lanes_f lanes_negate_bit(const lanes_f a, const lanes_u u, const int n) {
+    const uint32x4_t sign = vshlq_n_u32(vshlq_u32(u, vdupq_n_s32(-n)), 31);
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), sign));
+}
+static inline __attribute__((always_inline)) float lanes_hsum(const lanes_f a) {
+    const float32x2_t s = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+#else
+#define CHORDS_LANES 0
+#endif
+
+#if CHORDS_LANES
+
+// Wrap phases back to [0, 1), same as phase -= (uint32_t)phase
+static inline __attribute__((always_inline)) lanes_f lanes_wrapf(const lanes_f p) {
+    return lanes_sub(p, lanes_from_u(lanes_to_u(p)));
+}
+
+// Half period table lookup shared by the waves below. reflect selects the
+// mirrored second half used by saw and square instead of the shifted one
+// used by sine. offset, when not NULL, holds the offset of each lane's
+// table from wt, to select the band-limited tables. Same arithmetic as
+// osc_sinf/osc_bl_sawf/osc_bl_sqrf.
+static inline __attribute__((always_inline))
+lanes_f lanes_half_wavef(const lanes_f p, const float *wt, const uint32_t size_exp, const bool reflect,
+                         const uint32_t *offset) {
+    const uint32_t size = 1U << size_exp;
+    const uint32_t mask = size - 1;
+    const lanes_f x0f = lanes_mul(p, lanes_dup(2.f * size));
+    const lanes_u x0p = lanes_to_u(x0f);
+    const lanes_f fr = lanes_sub(x0f, lanes_from_u(x0p));
+
+    uint32_t idx[4] __attribute__((aligned(16)));
+    float y0[4] __attribute__((aligned(16)));
+    float y1[4] __attribute__((aligned(16)));
+    lanes_store_u(idx, x0p);
+    for (int l = 0; l < 4; l++) {
+        uint32_t x0, x1;
+        if (!reflect) {
+            x0 = idx[l] & mask;
+            x1 = (x0 + 1) & mask;
+        } else if (idx[l] < size) {
+            x0 = idx[l];
+            x1 = x0 + 1;
+        } else {
+            x0 = size - (idx[l] & mask);
+            x1 = x0 - 1;
+        }
+        if (offset) {
+            x0 += offset[l];
+            x1 += offset[l];
+        }
+        y0[l] = wt[x0];
+        y1[l] = wt[x1];
+    }
+    const lanes_f a = lanes_load(y0);
+    const lanes_f y = lanes_add(a, lanes_mul(fr, lanes_sub(lanes_load(y1), a)));
+    return lanes_negate_bit(y, x0p, size_exp);
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_sinf(const lanes_f p) {
+    return lanes_half_wavef(p, wt_sine_lut_f, k_wt_sine_size_exp, false, NULL);
+}
+
+// offset holds idx * k_wt_*_lut_size for each lane, idx as for osc_bl_sawf
+static inline __attribute__((always_inline)) lanes_f lanes_bl_sawf(const lanes_f p, const uint32_t *offset) {
+    return lanes_half_wavef(p, wt_saw_lut_f, k_wt_saw_size_exp, true, offset);
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_bl_sqrf(const lanes_f p, const uint32_t *offset) {
+    return lanes_half_wavef(p, wt_sqr_lut_f, k_wt_sqr_size_exp, true, offset);
+}
+
+// Same lookups on 32-bit fixed point phases, see phase_q32.h. The fraction
+// is kept to 31 bits so that the signed SSE2 conversion can be used.
+static inline __attribute__((always_inline))
+lanes_f lanes_half_wave_q32f(const lanes_u p, const float *wt, const uint32_t size_exp, const bool reflect,
+                             const uint32_t *offset) {
+    const uint32_t size = 1U << size_exp;
+    const uint32_t mask = size - 1;
+    const lanes_u x0p = lanes_shr_u(p, 31 - size_exp);
+    const lanes_f fr = lanes_mul(lanes_from_u(lanes_shr_u(lanes_shl_u(p, size_exp + 1), 1)),
+                                 lanes_dup(2.f * PHASE_Q32_RECIP));
+
+    uint32_t idx[4] __attribute__((aligned(16)));
+    float y0[4] __attribute__((aligned(16)));
+    float y1[4] __attribute__((aligned(16)));
+    lanes_store_u(idx, x0p);
+    for (int l = 0; l < 4; l++) {
+        uint32_t x0, x1;
+        if (!reflect) {
+            x0 = idx[l] & mask;
+            x1 = (x0 + 1) & mask;
+        } else if (idx[l] < size) {
+            x0 = idx[l];
+            x1 = x0 + 1;
+        } else {
+            x0 = size - (idx[l] & mask);
+            x1 = x0 - 1;
+        }
+        if (offset) {
+            x0 += offset[l];
+            x1 += offset[l];
+        }
+        y0[l] = wt[x0];
+        y1[l] = wt[x1];
+    }
+    const lanes_f a = lanes_load(y0);
+    const lanes_f y = lanes_add(a, lanes_mul(fr, lanes_sub(lanes_load(y1), a)));
+    return lanes_negate_bit(y, x0p, size_exp);
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_q32_sinf(const lanes_u p) {
+    return lanes_half_wave_q32f(p, wt_sine_lut_f, k_wt_sine_size_exp, false, NULL);
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_q32_bl_sawf(const lanes_u p, const uint32_t *offset) {
+    return lanes_half_wave_q32f(p, wt_saw_lut_f, k_wt_saw_size_exp, true, offset);
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_q32_bl_sqrf(const lanes_u p, const uint32_t *offset) {
+    return lanes_half_wave_q32f(p, wt_sqr_lut_f, k_wt_sqr_size_exp, true, offset);
+}
+
+#endif // CHORDS_LANES
+
+#endif //CHORDS_OSC_LANES_H
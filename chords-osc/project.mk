@@ -8,7 +8,7 @@ UCSRC =
 
 UCXXSRC = chords.cpp
 
-UINCDIR =
+UINCDIR = ../common
 
 UDEFS =
 
@@ -0,0 +1,49 @@
+//
+// Free running cycle counter for measuring the cost of a hook.
+//
+// On the Cortex-M4 this is the DWT cycle counter, started by
+// cycles_init(). Other builds (the host tools) read the monotonic clock and
+// scale it to 168 MHz cycles, so that budgets can be given in target cycles
+// everywhere. Only differences of two readings are meaningful, the count
+// wraps around.
+//
+
+#ifndef COMMON_CYCLES_H
+#define COMMON_CYCLES_H
+
+#include <stdint.h>
+
+#define k_cycles_core_hz (168000000U)
+
+#if defined(__ARM_ARCH_7EM__)
+
+#define CYCLES_DEMCR      (*(volatile uint32_t *)0xE000EDFC)
+#define CYCLES_DWT_CTRL   (*(volatile uint32_t *)0xE0001000)
+#define CYCLES_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+
+static inline void cycles_init(void) {
+    CYCLES_DEMCR |= 1U << 24; // TRCENA
+    CYCLES_DWT_CTRL |= 1U;    // CYCCNTENA
+}
+
+static inline __attribute__((always_inline)) uint32_t cycles_now(void) {
+    return CYCLES_DWT_CYCCNT;
+}
+
+#else
+
+#include <time.h>
+
+static inline void cycles_init(void) {
+}
+
+static inline uint32_t cycles_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * k_cycles_core_hz
+                      + (uint64_t)ts.tv_nsec * (k_cycles_core_hz / 1000000U) / 1000U);
+}
+
+#endif
+
+#endif //COMMON_CYCLES_H
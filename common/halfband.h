@@ -0,0 +1,58 @@
+//
+// Polyphase halfband decimators by 2, for units that run part of their
+// processing oversampled.
+//
+// A halfband FIR has every other tap zero apart from the centre one, which
+// is 1/2, so an output sample costs K multiplies on the symmetric pairs of
+// odd taps plus one for the centre. Only every second output is computed.
+// Two designs, minimax on the stopband, in cycles per input sample:
+//
+//   k_halfband_11: 11 taps, stopband from 0.425, -84 dB. First stage of a
+//                  4x decimation, which only has to keep the band the
+//                  second stage passes.
+//   k_halfband_19: 19 taps, passband to 0.15 and stopband from 0.35,
+//                  -70 dB. 2x decimation, or the last stage of 4x.
+//
+// The input block has to be preceded by halfband_hist(K) samples of room,
+// holding the end of the previous input on entry. halfband_decimate()
+// moves the end of the block there for the next call.
+//
+
+#ifndef COMMON_HALFBAND_H
+#define COMMON_HALFBAND_H
+
+#include <stdint.h>
+
+// Coefficients of taps +/-1, +/-3, ... +/-(2K-1)
+static const float k_halfband_11[3] = { 0.2961724057f, -0.0539048906f, 0.0077624409f };
+static const float k_halfband_19[5] = { 0.3097957908f, -0.0827860932f, 0.0311405117f, -0.0101891215f, 0.0021879274f };
+
+// Past input samples needed before the block
+#define halfband_hist(K) (4 * (K) - 3)
+
+// y[n] from x[2n + 1] and the 4K - 2 samples before, frames outputs from
+// 2 * frames inputs. The delay is 2K - 1 input samples.
+template <uint32_t K>
+static inline void halfband_decimate(float * __restrict y, float * __restrict x, const uint32_t frames,
+                                     const float (&a)[K]) {
+    for (uint32_t n = 0; n < frames; n++) {
+        const float * c = x + 2 * (int32_t)n + 2 - 2 * (int32_t)K; // centre tap
+        // Two sums so that the adds do not all wait on each other
+        float acc0 = 0.5f * c[0];
+        float acc1 = 0.f;
+        for (uint32_t k = 0; k < K; k += 2) {
+            acc0 += a[k] * (c[-(int32_t)(2 * k + 1)] + c[2 * k + 1]);
+            if (k + 1 < K) {
+                acc1 += a[k + 1] * (c[-(int32_t)(2 * k + 3)] + c[2 * k + 3]);
+            }
+        }
+        y[n] = acc0 + acc1;
+    }
+    const int32_t hist = halfband_hist(K);
+    const float * src = x + 2 * frames - hist;
+    for (int32_t i = 0; i < hist; i++) {
+        x[i - hist] = src[i];
+    }
+}
+
+#endif //COMMON_HALFBAND_H
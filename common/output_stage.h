@@ -0,0 +1,136 @@
+//
+// Output stage shared by the oscillators.
+//
+// The render kernels write their sum to a float block and this stage does
+// the rest in one pass: gain, osc_softclipf(0.05f, .) and the saturating
+// conversion to q31. The result is the same as
+//
+//   y[i] = f32_to_q31(osc_softclipf(0.05f, x[i] * gain));
+//
+// SSE2 and NEON builds process 4 frames at a time. On the Cortex-M4 the
+// conversion is a single VCVT to fixed point with 31 fraction bits, which
+// saturates by itself, so no scaling multiply is needed.
+//
+// Oscillators that run the softclip at a higher rate use the two halves on
+// their own: output_softclip() in place on the oversampled block, then
+// output_q31() for the saturating conversion after decimation.
+//
+
+#ifndef COMMON_OUTPUT_STAGE_H
+#define COMMON_OUTPUT_STAGE_H
+
+#include "userosc.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define k_output_softclip_c (0.05f)
+
+// Largest block the oscillators hand to the stage at once
+#define k_output_block (64)
+
+// Saturating conversion, s is within [-1, 1] unless the VCVT is used
+static inline __attribute__((always_inline)) q31_t output_q31_1(const float s) {
+#if defined(__ARM_ARCH_7EM__) && defined(__ARM_FP)
+    float q = s;
+    __asm__ ("vcvt.s32.f32 %0, %0, #31" : "+t" (q));
+    union { float f; q31_t i; } u = { q };
+    return u.i;
+#else
+    return f32_to_q31(s);
+#endif
+}
+
+static inline __attribute__((always_inline)) q31_t output_softclip_q31_1(const float x, const float gain) {
+    return output_q31_1(osc_softclipf(k_output_softclip_c, x * gain));
+}
+
+#if defined(__SSE2__)
+static inline __attribute__((always_inline)) __m128 output_softclip4(const __m128 x, const __m128 g) {
+    const __m128 s = _mm_min_ps(_mm_max_ps(_mm_mul_ps(x, g), _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+    return _mm_sub_ps(s, _mm_mul_ps(_mm_set1_ps(k_output_softclip_c), _mm_mul_ps(_mm_mul_ps(s, s), s)));
+}
+
+static inline __attribute__((always_inline)) __m128i output_q31_4(const __m128 s) {
+    const __m128 q = _mm_mul_ps(s, _mm_set1_ps((float)0x7FFFFFFF));
+    // CVTTPS2DQ gives 0x80000000 above 2^31 - 1, flip those to Q31_MAX
+    const __m128i over = _mm_castps_si128(_mm_cmpge_ps(q, _mm_set1_ps(2147483648.f)));
+    return _mm_xor_si128(_mm_cvttps_epi32(q), over);
+}
+#elif defined(__ARM_NEON)
+static inline __attribute__((always_inline)) float32x4_t output_softclip4(const float32x4_t x, const float32x4_t g) {
+    const float32x4_t s = vminq_f32(vmaxq_f32(vmulq_f32(x, g), vdupq_n_f32(-1.f)), vdupq_n_f32(1.f));
+    return vsubq_f32(s, vmulq_f32(vdupq_n_f32(k_output_softclip_c), vmulq_f32(vmulq_f32(s, s), s)));
+}
+
+static inline __attribute__((always_inline)) int32x4_t output_q31_4(const float32x4_t s) {
+    // Saturating conversion to fixed point with 31 fraction bits
+    return vcvtq_n_s32_f32(s, 31);
+}
+#endif
+
+static inline void output_softclip_q31(q31_t * __restrict y, const float * __restrict x,
+                                       const uint32_t frames, const float gain) {
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_si128((__m128i *)&y[i], output_q31_4(output_softclip4(_mm_loadu_ps(&x[i]), g)));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_s32(&y[i], output_q31_4(output_softclip4(vld1q_f32(&x[i]), g)));
+    }
+#endif
+    for (; i < frames; i++) {
+        y[i] = output_softclip_q31_1(x[i], gain);
+    }
+}
+
+// Gain and softclip only, in place
+static inline void output_softclip(float * __restrict x, const uint32_t frames, const float gain) {
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(&x[i], output_softclip4(_mm_loadu_ps(&x[i]), g));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_f32(&x[i], output_softclip4(vld1q_f32(&x[i]), g));
+    }
+#endif
+    for (; i < frames; i++) {
+        x[i] = osc_softclipf(k_output_softclip_c, x[i] * gain);
+    }
+}
+
+// Saturating conversion only, for a block that went through
+// output_softclip() and may since have overshot a little
+static inline void output_q31(q31_t * __restrict y, const float * __restrict x, const uint32_t frames) {
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 s = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&x[i]), _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+        _mm_storeu_si128((__m128i *)&y[i], output_q31_4(s));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_s32(&y[i], output_q31_4(vld1q_f32(&x[i])));
+    }
+#endif
+    for (; i < frames; i++) {
+#if defined(__ARM_ARCH_7EM__) && defined(__ARM_FP)
+        y[i] = output_q31_1(x[i]);
+#else
+        y[i] = output_q31_1(clip1m1f(x[i]));
+#endif
+    }
+}
+
+#endif //COMMON_OUTPUT_STAGE_H
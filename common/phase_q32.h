@@ -0,0 +1,76 @@
+//
+// 32-bit fixed point phase accumulators.
+//
+// A phase in [0, 1) is kept as a uint32_t scaled by 2^32, so adding the
+// increment wraps around for free and the resolution does not depend on
+// the phase value. The lookups below read the sine/saw/square tables
+// straight from the integer phase and return the same values as
+// osc_sinf/osc_sawf/osc_sqrf.
+//
+
+#ifndef COMMON_PHASE_Q32_H
+#define COMMON_PHASE_Q32_H
+
+#include "userosc.h"
+
+#define PHASE_Q32_ONE   (4294967296.f)
+#define PHASE_Q32_RECIP (2.3283064365386963e-10f)
+
+// Increment for w0 in cycles per sample. Whole cycles are dropped first,
+// as the float accumulators do after each step.
+static inline __attribute__((always_inline)) uint32_t phase_q32_from_f32(float w) {
+    w -= (uint32_t)w;
+    return (uint32_t)(w * PHASE_Q32_ONE);
+}
+
+static inline __attribute__((always_inline)) float phase_q32_to_f32(const uint32_t p) {
+    return p * PHASE_Q32_RECIP;
+}
+
+// Half period table lookup, the top size_exp+1 bits select the entry and
+// the rest is the interpolation fraction. reflect selects the mirrored
+// second half used by saw and square instead of the shifted one used by
+// sine.
+static inline __attribute__((always_inline))
+float phase_q32_half_wavef(const uint32_t p, const float *wt, const uint32_t size_exp, const bool reflect) {
+    const uint32_t size = 1U << size_exp;
+    const uint32_t mask = size - 1;
+    const uint32_t x0p = p >> (31 - size_exp);
+    const float fr = (uint32_t)(p << (size_exp + 1)) * PHASE_Q32_RECIP;
+    uint32_t x0, x1;
+    if (!reflect) {
+        x0 = x0p & mask;
+        x1 = (x0 + 1) & mask;
+    } else if (x0p < size) {
+        x0 = x0p;
+        x1 = x0 + 1;
+    } else {
+        x0 = size - (x0p & mask);
+        x1 = x0 - 1;
+    }
+    const float y = linintf(fr, wt[x0], wt[x1]);
+    return (x0p & size) ? -y : y;
+}
+
+static inline __attribute__((always_inline)) float phase_q32_sinf(const uint32_t p) {
+    return phase_q32_half_wavef(p, wt_sine_lut_f, k_wt_sine_size_exp, false);
+}
+
+static inline __attribute__((always_inline)) float phase_q32_sawf(const uint32_t p) {
+    return phase_q32_half_wavef(p, wt_saw_lut_f, k_wt_saw_size_exp, true);
+}
+
+static inline __attribute__((always_inline)) float phase_q32_sqrf(const uint32_t p) {
+    return phase_q32_half_wavef(p, wt_sqr_lut_f, k_wt_sqr_size_exp, true);
+}
+
+// Band-limited variants, idx as for osc_bl_sawf/osc_bl_sqrf
+static inline __attribute__((always_inline)) float phase_q32_bl_sawf(const uint32_t p, const uint8_t idx) {
+    return phase_q32_half_wavef(p, &wt_saw_lut_f[idx * k_wt_saw_lut_size], k_wt_saw_size_exp, true);
+}
+
+static inline __attribute__((always_inline)) float phase_q32_bl_sqrf(const uint32_t p, const uint8_t idx) {
+    return phase_q32_half_wavef(p, &wt_sqr_lut_f[idx * k_wt_sqr_lut_size], k_wt_sqr_size_exp, true);
+}
+
+#endif //COMMON_PHASE_Q32_H
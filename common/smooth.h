@@ -0,0 +1,88 @@
+//
+// Per-block parameter smoothing.
+//
+// A value set from the PARAM hook moves to its new target along a linear
+// ramp of SMOOTH_FRAMES frames instead of jumping there. The ramp is
+// followed at block rate: smooth_block() hands out the value at the start
+// of the block and one increment per frame, which the units interpolate
+// with the same way they follow the shape LFO. A new target while a ramp
+// runs starts a new ramp from where the value is. The last block of a ramp
+// lands exactly on the target and the increment is exactly 0 from then on,
+// so a settled parameter costs one compare per block and the units can
+// keep their steady-state paths for it. The first value set after
+// smooth_init() is taken at once, only later changes are ramped.
+//
+
+#ifndef COMMON_SMOOTH_H
+#define COMMON_SMOOTH_H
+
+#include <stdint.h>
+
+// Length of the ramps, 10 ms at 48 kHz
+#ifndef SMOOTH_FRAMES
+#define SMOOTH_FRAMES (480)
+#endif
+
+typedef struct Smooth {
+    float value; //at the start of the next block
+    float target;
+    float step; //per frame while the ramp runs
+    uint32_t left; //frames of the ramp still to go, 0 once settled
+    bool unset; //no value set since smooth_init()
+} Smooth;
+
+// Jump to v
+static inline void smooth_reset(Smooth &s, const float v) {
+    s.value = v;
+    s.target = v;
+    s.step = 0.f;
+    s.left = 0;
+    s.unset = false;
+}
+
+// Start at v until the first smooth_set(), for the INIT hook
+static inline void smooth_init(Smooth &s, const float v) {
+    smooth_reset(s, v);
+    s.unset = true;
+}
+
+static inline void smooth_set(Smooth &s, const float target) {
+    if (s.unset) {
+        smooth_reset(s, target);
+        return;
+    }
+    if (target == s.target) {
+        return;
+    }
+    s.target = target;
+    s.left = SMOOTH_FRAMES;
+    s.step = (target - s.value) * (1.f / SMOOTH_FRAMES);
+}
+
+// Value at the start of the block in v and its increment per frame. A
+// ramp that ends within the block is stretched to the end of it.
+static inline __attribute__((always_inline)) float smooth_block(Smooth &s, const uint32_t frames, float &v) {
+    v = s.value;
+    if (!s.left) {
+        return 0.f;
+    }
+    if (s.left <= frames) {
+        s.value = s.target;
+        s.left = 0;
+        return (s.target - v) / frames;
+    }
+    s.left -= frames;
+    s.value += s.step * frames;
+    return s.step;
+}
+
+// x *= g in place, g moving by inc per frame, for a gain that is taken
+// in front of a stage with a fixed gain argument
+static inline void smooth_ramp(float * __restrict x, const uint32_t frames, float g, const float inc) {
+    for (uint32_t i = 0; i < frames; i++) {
+        x[i] *= g;
+        g += inc;
+    }
+}
+
+#endif //COMMON_SMOOTH_H
@@ -0,0 +1,103 @@
+//
+// Controls exported by the distort effect.
+//
+
+#ifndef DISTORT_MOD_DISTORT_H
+#define DISTORT_MOD_DISTORT_H
+
+#include <stdint.h>
+
+// Antiderivative anti-aliasing of the shapers on (1) or off (0, default)
+// until distort_set_adaa() is called. It changes the sound and adds a half
+// sample of delay, and the NTS-1 has no free control to select it, so the
+// shipped unit keeps the plain shapers unless built with it.
+#ifndef DISTORT_ADAA
+#define DISTORT_ADAA 0
+#endif
+
+// Whether the ADAA kernels are compiled in, one per shaper next to the
+// plain ones. The unit only carries them when it is built with ADAA on,
+// the host tools switch it at run time.
+#if DISTORT_ADAA || !defined(__ARM_ARCH_7EM__)
+#define DISTORT_ADAA_KERNELS 1
+#else
+#define DISTORT_ADAA_KERNELS 0
+#endif
+
+// Table curve (1 tanh, 2 tube, 3 diode) used instead of the shape picked
+// with the time knob until distort_set_curve() is called. The knob keeps
+// its four zones for soft, hard, wrap and fold, so 0, the default, leaves
+// the unit as it was.
+#ifndef DISTORT_CURVE
+#define DISTORT_CURVE 0
+#endif
+
+// Whether the table curves are compiled in. Their table takes 8K of SDRAM
+// and their kernel code space, so the unit only carries them when it is
+// built with a curve. The host tools select them at run time.
+#if DISTORT_CURVE || !defined(__ARM_ARCH_7EM__)
+#define DISTORT_CURVES 1
+#else
+#define DISTORT_CURVES 0
+#endif
+
+// Tempo-synced modulation until distort_set_sync() is called, off by
+// default. The NTS-1 has no control for it, on the device it is set at
+// build time only.
+#ifndef DISTORT_SYNC_BEATS
+#define DISTORT_SYNC_BEATS (0.f)
+#endif
+#ifndef DISTORT_SYNC_DEPTH
+#define DISTORT_SYNC_DEPTH (0.5f)
+#endif
+#ifndef DISTORT_SYNC_THRESHOLD
+#define DISTORT_SYNC_THRESHOLD (0.5f)
+#endif
+
+// Input peak below which blocks are bypassed until distort_set_silence()
+// is called, about -100 dB, 0 to always shape. The input has to stay under
+// it for DISTORT_SILENCE_HOLD frames first.
+#ifndef DISTORT_SILENCE
+#define DISTORT_SILENCE (1e-5f)
+#endif
+#ifndef DISTORT_SILENCE_HOLD
+#define DISTORT_SILENCE_HOLD (256)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct distort_stats_s {
+    uint32_t blocks; //MODFX_PROCESS calls
+    uint32_t bypassed_blocks; //calls that wrote silence without shaping
+    uint32_t bypassed; //1 while the input is taken as silent
+} distort_stats_t;
+
+// Counters since MODFX_INIT and the current bypass state
+const distort_stats_t * distort_stats(void);
+
+// Turn the antiderivative anti-aliasing on or off, taken at the start of
+// the next MODFX_PROCESS block. No effect without DISTORT_ADAA_KERNELS.
+void distort_set_adaa(uint32_t on);
+
+// Shape the input with a table curve, 1 tanh, 2 tube (asymmetric) or 3
+// diode, instead of the time knob's shape, 0 to go back to the knob. The
+// curve's table is built on the spot. No effect without DISTORT_CURVES.
+void distort_set_curve(uint32_t curve);
+
+// Modulate the depth and the clip threshold with a falling ramp every
+// `beats` beats of fx_get_bpmf(), 0 beats turns it off. At the top of the
+// ramp depth (0 to 1) is added to the depth knob and threshold (0 to 1)
+// lowers the clip level by up to 75%. The period starts at MODFX_INIT, the
+// API gives no bar position to lock to.
+void distort_set_sync(float beats, float depth, float threshold);
+
+// Input peak below which blocks are bypassed, 0 turns the bypass off
+void distort_set_silence(float threshold);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //DISTORT_MOD_DISTORT_H
@@ -0,0 +1,105 @@
+//
+// 4-wide float lanes for the distort shapers.
+//
+// DISTORT_SIMD selects the kernel at compile time:
+//  0: scalar, one sample at a time
+//  1: two stereo frames of main and of sub per step with SSE2 or NEON when
+//     the compiler targets one of them, scalar otherwise (default)
+// The Cortex-M4 FPU has no packed float instructions, so target builds
+// always end up on the scalar kernel.
+//
+
+#ifndef DISTORT_MOD_LANES_H
+#define DISTORT_MOD_LANES_H
+
+#include "usermodfx.h"
+
+#ifndef DISTORT_SIMD
+#define DISTORT_SIMD 1
+#endif
+
+#if DISTORT_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#define DISTORT_LANES 1
+
+typedef __m128 lanes_f;
+typedef __m128 lanes_m; //lane masks
+
+static inline __attribute__((always_inline)) lanes_f lanes_dup(const float x) { return _mm_set1_ps(x); }
+static inline __attribute__((always_inline)) lanes_f lanes_load(const float *p) { return _mm_loadu_ps(p); }
+static inline __attribute__((always_inline)) void lanes_store(float *p, const lanes_f a) { _mm_storeu_ps(p, a); }
+static inline __attribute__((always_inline)) lanes_f lanes_add(const lanes_f a, const lanes_f b) { return _mm_add_ps(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_sub(const lanes_f a, const lanes_f b) { return _mm_sub_ps(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_mul(const lanes_f a, const lanes_f b) { return _mm_mul_ps(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_div(const lanes_f a, const lanes_f b) { return _mm_div_ps(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_min(const lanes_f a, const lanes_f b) { return _mm_min_ps(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_max(const lanes_f a, const lanes_f b) { return _mm_max_ps(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_abs(const lanes_f a) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.f), a);
+}
+// Same as floor_fast() in test.cpp, for |a| < 2^31
+static inline __attribute__((always_inline)) lanes_f lanes_floor(const lanes_f a) {
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.f)));
+}
+// Truncating conversion, for the table indices
+static inline __attribute__((always_inline)) void lanes_store_i(int32_t *p, const lanes_f a) {
+    _mm_storeu_si128((__m128i *)p, _mm_cvttps_epi32(a));
+}
+static inline __attribute__((always_inline)) lanes_m lanes_lt(const lanes_f a, const lanes_f b) { return _mm_cmplt_ps(a, b); }
+// m ? a : b
+static inline __attribute__((always_inline)) lanes_f lanes_select(const lanes_m m, const lanes_f a, const lanes_f b) {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+// { a[2], a[3], b[0], b[1] }, the frame before each frame of b when a is
+// the previous step
+static inline __attribute__((always_inline)) lanes_f lanes_shift2(const lanes_f a, const lanes_f b) {
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+#elif DISTORT_SIMD && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DISTORT_LANES 1
+
+typedef float32x4_t lanes_f;
+typedef uint32x4_t lanes_m;
+
+static inline __attribute__((always_inline)) lanes_f lanes_dup(const float x) { return vdupq_n_f32(x); }
+static inline __attribute__((always_inline)) lanes_f lanes_load(const float *p) { return vld1q_f32(p); }
+static inline __attribute__((always_inline)) void lanes_store(float *p, const lanes_f a) { vst1q_f32(p, a); }
+static inline __attribute__((always_inline)) lanes_f lanes_add(const lanes_f a, const lanes_f b) { return vaddq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_sub(const lanes_f a, const lanes_f b) { return vsubq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_mul(const lanes_f a, const lanes_f b) { return vmulq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_div(const lanes_f a, const lanes_f b) {
+#if defined(__aarch64__)
+    return vdivq_f32(a, b);
+#else
+    // No divide on ARMv7 NEON, reciprocal estimate and two Newton steps
+    float32x4_t r = vrecpeq_f32(b);
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    return vmulq_f32(a, r);
+#endif
+}
+static inline __attribute__((always_inline)) lanes_f lanes_min(const lanes_f a, const lanes_f b) { return vminq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_max(const lanes_f a, const lanes_f b) { return vmaxq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_abs(const lanes_f a) { return vabsq_f32(a); }
+static inline __attribute__((always_inline)) lanes_f lanes_floor(const lanes_f a) {
+    const float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(a));
+    const uint32x4_t one = vandq_u32(vcgtq_f32(t, a), vreinterpretq_u32_f32(vdupq_n_f32(1.f)));
+    return vsubq_f32(t, vreinterpretq_f32_u32(one));
+}
+static inline __attribute__((always_inline)) void lanes_store_i(int32_t *p, const lanes_f a) { vst1q_s32(p, vcvtq_s32_f32(a)); }
+static inline __attribute__((always_inline)) lanes_m lanes_lt(const lanes_f a, const lanes_f b) { return vcltq_f32(a, b); }
+static inline __attribute__((always_inline)) lanes_f lanes_select(const lanes_m m, const lanes_f a, const lanes_f b) {
+    return vbslq_f32(m, a, b);
+}
+static inline __attribute__((always_inline)) lanes_f lanes_shift2(const lanes_f a, const lanes_f b) {
+    return vextq_f32(a, b, 2);
+}
+
+#else
+#define DISTORT_LANES 0
+#endif
+
+#endif //DISTORT_MOD_LANES_H
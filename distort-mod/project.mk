@@ -8,7 +8,7 @@ UCSRC =
 
 UCXXSRC = test.cpp
 
-UINCDIR =
+UINCDIR = ../common
 
 UDEFS =
 
@@ -4,11 +4,54 @@
 
 #include "usermodfx.h"
 #include "fx_api.h"
+#include "lanes.h"
+#include "distort.h"
+#include "smooth.h"
 
-float dist_depth;
+// First order antiderivative anti-aliasing of the shapers: each output is
+// the mean of the shaper between the previous input and this one,
+//
+//   y[n] = (F(x[n]) - F(x[n-1])) / (x[n] - x[n-1])
+//
+// with F the antiderivative, which cuts the aliasing of the corners and
+// jumps at the cost of a half sample delay and a gentle roll-off near
+// Nyquist. Below k_adaa_eps the quotient is ill-conditioned and the shaper
+// is taken at the midpoint instead.
+#define k_adaa_eps (1e-3f)
+
+// Follows the depth knob over SMOOTH_FRAMES
+Smooth dist_depth;
 int dist_type;
 float dpth;
 float len;
+// Whether the platform has a sub timbre, the NTS-1 only has main
+static bool s_has_sub;
+static bool s_adaa = DISTORT_ADAA;
+// Last shaper input of main L/R and sub L/R, for the ADAA kernels
+static float s_adaa_x1[4];
+
+// Silence bypass: input peak below which blocks are skipped, 0 when off,
+// and the quiet frames seen so far. See MODFX_PROCESS.
+static float s_silence = DISTORT_SILENCE;
+static uint32_t s_quiet;
+static bool s_bypass;
+static distort_stats_t s_stats;
+#if DISTORT_CURVES
+// Table curve used instead of the time knob's shapes, 0 for none
+static uint32_t s_curve = DISTORT_CURVE;
+#endif
+
+enum {
+    k_type_soft,
+    k_type_hard,
+    k_type_wrap,
+    k_type_fold,
+    k_type_tanh,
+    k_type_tube,
+    k_type_diode,
+    k_num_types,
+    k_type_table = k_type_tanh, //kernel of all the table curves
+};
 
 float __fast_inline softclip(float in, float lim, float smooth) {
     float out = clipminmaxf(-lim, in, lim);
@@ -20,71 +63,660 @@ float __fast_inline hardclip(float x, float lim) {
     return clipminmaxf(-lim, x, lim);
 }
 
+// floor() by truncation, VCVT on the M4 where floorf() is a library call.
+// Exact for |x| < 2^31, far more than the shapers below ever see.
+float __fast_inline floor_fast(float x) {
+    const float t = (float)(int32_t)x;
+    return (t > x) ? t - 1.f : t;
+}
+
+// Wrap and fold take x back into [-lim, lim] in one step instead of one
+// period at a time, so that a hot input at full depth costs the same as a
+// quiet one. Away from the period edges the result is the one of the
+// subtraction loops they replace to within 5e-6 over the +-11 range of the
+// gain stage, most of it the rounding the loops piled up. On an edge of the
+// wrap the loops gave +lim from above 0 and -lim from below, this gives -lim.
+
+// Sawtooth of period 2*lim
 float __fast_inline wrap(float x, float lim) {
-    float out = x;
-    while (out > lim || out < -lim) {
-        if (out > lim) {
-            out = -lim + (out-lim);
-        } else if (out < -lim) {
-            out = lim - (-out-lim);
-        }
-    }
-    return out;
+    const float p = 2.f * lim;
+    const float t = x + lim;
+    return t - p * floor_fast(t * (1.f / p)) - lim;
 }
 
+// Triangle of period 4*lim
 float __fast_inline fold(float x, float lim) {
-    float out = x;
-    while (out > lim || out < -lim) {
-        if (out > lim) {
-            out = lim - (out - lim);
-        } else if (out < -lim) {
-            out = -lim + (-out-lim);
+    const float p = 4.f * lim;
+    const float t = x + lim;
+    const float m = t - p * floor_fast(t * (1.f / p));
+    return lim - fabsf(m - 2.f * lim);
+}
+
+// Antiderivatives of the shapers, continuous and 0 at x = 0. Past the clip
+// level both clippers continue with the slope of their plateau.
+float __fast_inline softclip_ad(float x, float lim, float smooth) {
+    const float c = clipminmaxf(-lim, x, lim);
+    const float c2 = c * c;
+    return c2 * (0.5f - 0.25f * smooth * c2) + (fabsf(x) - fabsf(c)) * (lim - smooth * lim * lim * lim);
+}
+
+float __fast_inline hardclip_ad(float x, float lim) {
+    const float c = clipminmaxf(-lim, x, lim);
+    return 0.5f * c * c + (fabsf(x) - fabsf(c)) * lim;
+}
+
+// The wrap has no DC over a period and y^2/2 matches across the jumps
+float __fast_inline wrap_ad(float x, float lim) {
+    const float y = wrap(x, lim);
+    return 0.5f * y * y;
+}
+
+// y^2/2 on the rising half of the triangle, lim^2 - y^2/2 on the falling one
+float __fast_inline fold_ad(float x, float lim) {
+    const float p = 4.f * lim;
+    const float t = x + lim;
+    const float d = t - p * floor_fast(t * (1.f / p)) - 2.f * lim;
+    const float y = lim - fabsf(d);
+    return (d < 0.f) ? 0.5f * y * y : lim * lim - 0.5f * y * y;
+}
+
+#if DISTORT_CURVES
+// Richer curves come from a transfer table, so that a curve costs one
+// interpolated lookup whatever it takes to compute. The table is built
+// for the selected curve when it is selected, only one is kept. The curve
+// g(u), u = x/lim, is sampled over |x| <= k_lut_range where all of them
+// have flattened out, scaled to the +-lim of the other shapers and held
+// past the ends. ad holds the antiderivative at the nodes, the exact
+// integral of the interpolated curve, for the ADAA kernels. The table goes
+// to SDRAM, the SRAM region of the unit only has 6K for code and data.
+#define k_lut_size (1024)
+#define k_lut_range (1.2f)
+#define k_lut_step (2.f * k_lut_range / k_lut_size)
+#define k_lut_lim (0.15f)
+
+typedef struct Lut {
+    float f[k_lut_size + 1];
+    float ad[k_lut_size + 1];
+} Lut;
+
+#ifndef __sdram
+#define __sdram __attribute__((section(".sdram")))
+#endif
+
+static __sdram Lut s_lut;
+// Curve the table holds, 0 until it is first built
+static uint32_t s_lut_curve;
+
+// e^x for the table builds, x <= 0: Taylor series of x/32 squared 5 times,
+// within 1e-6
+static float lut_expf(float x) {
+    const float y = x * (1.f / 32.f);
+    float e = 1.f + y * (1.f + y * (1.f / 2 + y * (1.f / 6 + y * (1.f / 24 + y * (1.f / 120
+              + y * (1.f / 720 + y * (1.f / 5040 + y * (1.f / 40320))))))));
+    for (int k = 0; k < 5; k++) {
+        e *= e;
+    }
+    return e;
+}
+
+static float lut_tanhf(float u) {
+    const float e = lut_expf(-2.f * fabsf(u));
+    return si_copysignf((1.f - e) / (1.f + e), u);
+}
+
+// The curve of a table type at u
+static float lut_curve(int type, float u) {
+    switch (type) {
+        case k_type_tanh:
+            return lut_tanhf(u);
+        case k_type_tube: //the negative half clips earlier and softer
+            return (u >= 0.f) ? lut_tanhf(u) : 0.6f * lut_tanhf(u * (1.f / 0.6f));
+        default: //diode pair, exponential knee
+            return si_copysignf(1.f - lut_expf(-fabsf(u)), u);
+    }
+}
+
+static void lut_build(Lut *t, int type) {
+    for (int k = 0; k <= k_lut_size; k++) {
+        const float x = k * k_lut_step - k_lut_range;
+        t->f[k] = k_lut_lim * lut_curve(type, x * (1.f / k_lut_lim));
+    }
+    // Trapezoids, from 0 at x = 0 so that the values stay small
+    t->ad[k_lut_size / 2] = 0.f;
+    for (int k = k_lut_size / 2; k < k_lut_size; k++) {
+        t->ad[k + 1] = t->ad[k] + 0.5f * k_lut_step * (t->f[k] + t->f[k + 1]);
+    }
+    for (int k = k_lut_size / 2; k > 0; k--) {
+        t->ad[k - 1] = t->ad[k] - 0.5f * k_lut_step * (t->f[k - 1] + t->f[k]);
+    }
+}
+
+// Build the table of a curve unless it holds it already
+static void lut_select(uint32_t curve) {
+    if (curve && curve != s_lut_curve) {
+        lut_build(&s_lut, k_type_table + curve - 1);
+        s_lut_curve = curve;
+    }
+}
+
+// Position of x in the tables, held at the ends
+float __fast_inline lut_pos(float x) {
+    return clipminmaxf(0.f, (x + k_lut_range) * (1.f / k_lut_step), k_lut_size - 0.001f);
+}
+
+float __fast_inline lut_shape(float x) {
+    const float p = lut_pos(x);
+    const uint32_t i = (uint32_t)p;
+    return linintf(p - i, s_lut.f[i], s_lut.f[i + 1]);
+}
+
+// Past the ends the curve is flat and its antiderivative linear
+float __fast_inline lut_shape_ad(float x) {
+    const float p = lut_pos(x);
+    const uint32_t i = (uint32_t)p;
+    const float fr = p - i;
+    const float a = s_lut.ad[i] + fr * k_lut_step * (s_lut.f[i] + 0.5f * fr * (s_lut.f[i + 1] - s_lut.f[i]));
+    const float r = x - clipminmaxf(-k_lut_range, x, k_lut_range);
+    return a + r * ((x > 0.f) ? s_lut.f[k_lut_size] : s_lut.f[0]);
+}
+#endif
+
+// Shaper of the given clip type, a template argument so each variant gets
+// its own branch-free loop
+template <int type>
+float __fast_inline shape(float x) {
+    switch (type) {
+        case k_type_soft:
+            return softclip(x, 0.15f, 0.15f);
+        case k_type_hard:
+            return hardclip(x, 0.15f);
+        case k_type_wrap:
+            return wrap(x, 0.15f);
+        case k_type_fold:
+            return fold(x, 0.15f);
+#if DISTORT_CURVES
+        default:
+            return lut_shape(x);
+#endif
+    }
+}
+
+template <int type>
+float __fast_inline shape_ad(float x) {
+    switch (type) {
+        case k_type_soft:
+            return softclip_ad(x, 0.15f, 0.15f);
+        case k_type_hard:
+            return hardclip_ad(x, 0.15f);
+        case k_type_wrap:
+            return wrap_ad(x, 0.15f);
+        case k_type_fold:
+            return fold_ad(x, 0.15f);
+#if DISTORT_CURVES
+        default:
+            return lut_shape_ad(x);
+#endif
+    }
+}
+
+// ADAA output for input x after x1, ad and ad1 their antiderivatives
+template <int type>
+float __fast_inline shape_adaa(float x, float x1, float ad, float ad1) {
+    const float dx = x - x1;
+    if (fabsf(dx) < k_adaa_eps) {
+        return shape<type>(0.5f * (x + x1));
+    }
+    return (ad - ad1) / dx;
+}
+
+#if DISTORT_LANES
+// The shapers above on 4 lanes
+static inline __attribute__((always_inline)) lanes_f lanes_hardclip(const lanes_f x, const float lim) {
+    return lanes_min(lanes_max(x, lanes_dup(-lim)), lanes_dup(lim));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_softclip(const lanes_f x, const float lim, const float smooth) {
+    const lanes_f out = lanes_hardclip(x, lim);
+    return lanes_sub(out, lanes_mul(lanes_dup(smooth), lanes_mul(lanes_mul(out, out), out)));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_wrap(const lanes_f x, const float lim) {
+    const float p = 2.f * lim;
+    const lanes_f t = lanes_add(x, lanes_dup(lim));
+    const lanes_f k = lanes_floor(lanes_mul(t, lanes_dup(1.f / p)));
+    return lanes_sub(lanes_sub(t, lanes_mul(lanes_dup(p), k)), lanes_dup(lim));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_fold(const lanes_f x, const float lim) {
+    const float p = 4.f * lim;
+    const lanes_f t = lanes_add(x, lanes_dup(lim));
+    const lanes_f m = lanes_sub(t, lanes_mul(lanes_dup(p), lanes_floor(lanes_mul(t, lanes_dup(1.f / p)))));
+    return lanes_sub(lanes_dup(lim), lanes_abs(lanes_sub(m, lanes_dup(2.f * lim))));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_softclip_ad(const lanes_f x, const float lim, const float smooth) {
+    const lanes_f c = lanes_hardclip(x, lim);
+    const lanes_f c2 = lanes_mul(c, c);
+    const lanes_f r = lanes_sub(lanes_abs(x), lanes_abs(c));
+    return lanes_add(lanes_mul(c2, lanes_sub(lanes_dup(0.5f), lanes_mul(lanes_dup(0.25f * smooth), c2))),
+                     lanes_mul(r, lanes_dup(lim - smooth * lim * lim * lim)));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_hardclip_ad(const lanes_f x, const float lim) {
+    const lanes_f c = lanes_hardclip(x, lim);
+    const lanes_f r = lanes_sub(lanes_abs(x), lanes_abs(c));
+    return lanes_add(lanes_mul(lanes_dup(0.5f), lanes_mul(c, c)), lanes_mul(r, lanes_dup(lim)));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_wrap_ad(const lanes_f x, const float lim) {
+    const lanes_f y = lanes_wrap(x, lim);
+    return lanes_mul(lanes_dup(0.5f), lanes_mul(y, y));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_fold_ad(const lanes_f x, const float lim) {
+    const float p = 4.f * lim;
+    const lanes_f t = lanes_add(x, lanes_dup(lim));
+    const lanes_f d = lanes_sub(lanes_sub(t, lanes_mul(lanes_dup(p), lanes_floor(lanes_mul(t, lanes_dup(1.f / p))))),
+                                lanes_dup(2.f * lim));
+    const lanes_f y = lanes_sub(lanes_dup(lim), lanes_abs(d));
+    const lanes_f h = lanes_mul(lanes_dup(0.5f), lanes_mul(y, y));
+    return lanes_select(lanes_lt(d, lanes_dup(0.f)), h, lanes_sub(lanes_dup(lim * lim), h));
+}
+
+#if DISTORT_CURVES
+// The table is gathered one lane at a time
+static inline __attribute__((always_inline)) lanes_f lanes_lut_pos(const lanes_f x) {
+    const lanes_f p = lanes_mul(lanes_add(x, lanes_dup(k_lut_range)), lanes_dup(1.f / k_lut_step));
+    return lanes_min(lanes_max(p, lanes_dup(0.f)), lanes_dup(k_lut_size - 0.001f));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_lut_shape(const lanes_f x) {
+    const lanes_f p = lanes_lut_pos(x);
+    const lanes_f fr = lanes_sub(p, lanes_floor(p));
+    int32_t idx[4];
+    float y0[4];
+    float y1[4];
+    lanes_store_i(idx, p);
+    for (int l = 0; l < 4; l++) {
+        y0[l] = s_lut.f[idx[l]];
+        y1[l] = s_lut.f[idx[l] + 1];
+    }
+    const lanes_f a = lanes_load(y0);
+    return lanes_add(a, lanes_mul(fr, lanes_sub(lanes_load(y1), a)));
+}
+
+static inline __attribute__((always_inline)) lanes_f lanes_lut_shape_ad(const lanes_f x) {
+    const lanes_f p = lanes_lut_pos(x);
+    const lanes_f fr = lanes_sub(p, lanes_floor(p));
+    int32_t idx[4];
+    float y0[4];
+    float y1[4];
+    float a0[4];
+    lanes_store_i(idx, p);
+    for (int l = 0; l < 4; l++) {
+        y0[l] = s_lut.f[idx[l]];
+        y1[l] = s_lut.f[idx[l] + 1];
+        a0[l] = s_lut.ad[idx[l]];
+    }
+    const lanes_f f0 = lanes_load(y0);
+    const lanes_f df = lanes_sub(lanes_load(y1), f0);
+    const lanes_f a = lanes_add(lanes_load(a0),
+                                lanes_mul(lanes_mul(fr, lanes_dup(k_lut_step)),
+                                          lanes_add(f0, lanes_mul(lanes_mul(lanes_dup(0.5f), fr), df))));
+    const lanes_f r = lanes_sub(x, lanes_hardclip(x, k_lut_range));
+    const lanes_f end = lanes_select(lanes_lt(lanes_dup(0.f), x), lanes_dup(s_lut.f[k_lut_size]), lanes_dup(s_lut.f[0]));
+    return lanes_add(a, lanes_mul(r, end));
+}
+#endif
+
+template <int type>
+static inline __attribute__((always_inline)) lanes_f lanes_shape(const lanes_f x) {
+    switch (type) {
+        case k_type_soft:
+            return lanes_softclip(x, 0.15f, 0.15f);
+        case k_type_hard:
+            return lanes_hardclip(x, 0.15f);
+        case k_type_wrap:
+            return lanes_wrap(x, 0.15f);
+        case k_type_fold:
+            return lanes_fold(x, 0.15f);
+#if DISTORT_CURVES
+        default:
+            return lanes_lut_shape(x);
+#endif
+    }
+}
+
+template <int type>
+static inline __attribute__((always_inline)) lanes_f lanes_shape_ad(const lanes_f x) {
+    switch (type) {
+        case k_type_soft:
+            return lanes_softclip_ad(x, 0.15f, 0.15f);
+        case k_type_hard:
+            return lanes_hardclip_ad(x, 0.15f);
+        case k_type_wrap:
+            return lanes_wrap_ad(x, 0.15f);
+        case k_type_fold:
+            return lanes_fold_ad(x, 0.15f);
+#if DISTORT_CURVES
+        default:
+            return lanes_lut_shape_ad(x);
+#endif
+    }
+}
+
+template <int type>
+static inline __attribute__((always_inline))
+lanes_f lanes_shape_adaa(const lanes_f x, const lanes_f x1, const lanes_f ad, const lanes_f ad1) {
+    const lanes_f dx = lanes_sub(x, x1);
+    const lanes_f mid = lanes_shape<type>(lanes_mul(lanes_dup(0.5f), lanes_add(x, x1)));
+    // The quotient of the ill-conditioned lanes is thrown away
+    return lanes_select(lanes_lt(lanes_abs(dx), lanes_dup(k_adaa_eps)), mid, lanes_div(lanes_sub(ad, ad1), dx));
+}
+#endif
+
+// Gain into the shaper and level after it, ramped linearly over the block
+// from their values at its first frame. Constant unless the tempo sync is
+// on, in which case level scales the clip threshold: a shaper at lim * k is
+// k times the shaper at lim of x / k.
+typedef struct Ramp {
+    float gain;
+    float gain_inc; //per frame
+    float level;
+    float level_inc;
+} Ramp;
+
+// Tempo-synced modulation, see distort_set_sync()
+typedef struct Sync {
+    float beats; //period, 0 when off
+    float depth;
+    float threshold;
+    float phase; //of the period at the start of the next block
+} Sync;
+
+static Sync s_sync = { DISTORT_SYNC_BEATS, DISTORT_SYNC_DEPTH, DISTORT_SYNC_THRESHOLD, 0.f };
+
+// Process one stereo bus with the given clip type, main and sub go through
+// the same kernel one after the other. x1 holds the last input of L and R.
+// 2 frames per step on the lanes, 1 in the scalar loop. xn and yn may be
+// the same buffer.
+template <int type, bool ad>
+static void process(const float *xn, float *yn, uint32_t frames, float gain, float *x1)
+{
+    const uint32_t n = 2 * frames;
+    if (n == 0) {
+        return;
+    }
+    // Previous input and its antiderivative for L and R
+    float xl = x1[0];
+    float xr = x1[1];
+    float al = 0.f;
+    float ar = 0.f;
+    if (ad) {
+        al = shape_ad<type>(xl);
+        ar = shape_ad<type>(xr);
+    }
+    // Kept in both modes so that switching to ADAA starts from the right
+    // sample, taken before an in place block is overwritten
+    x1[0] = xn[n-2] * gain;
+    x1[1] = xn[n-1] * gain;
+    uint32_t i = 0;
+#if DISTORT_LANES
+    const lanes_f g = lanes_dup(gain);
+    if (ad) {
+        // Lanes 2 and 3 of the previous step hold the frame before
+        float v[4] = { 0.f, 0.f, xl, xr };
+        lanes_f xp = lanes_load(v);
+        v[2] = al; v[3] = ar;
+        lanes_f ap = lanes_load(v);
+        for (; i + 4 <= n; i += 4) {
+            const lanes_f x = lanes_mul(lanes_load(&xn[i]), g);
+            const lanes_f a = lanes_shape_ad<type>(x);
+            lanes_store(&yn[i], lanes_shape_adaa<type>(x, lanes_shift2(xp, x), a, lanes_shift2(ap, a)));
+            xp = x;
+            ap = a;
+        }
+        lanes_store(v, xp); xl = v[2]; xr = v[3];
+        lanes_store(v, ap); al = v[2]; ar = v[3];
+    } else {
+        for (; i + 4 <= n; i += 4) {
+            lanes_store(&yn[i], lanes_shape<type>(lanes_mul(lanes_load(&xn[i]), g)));
         }
     }
-    return out;
+#endif
+    for (; i < n; i += 2) {
+        const float l = xn[i] * gain;
+        const float r = xn[i+1] * gain;
+        if (ad) {
+            const float a = shape_ad<type>(l);
+            const float b = shape_ad<type>(r);
+            yn[i] = shape_adaa<type>(l, xl, a, al);
+            yn[i+1] = shape_adaa<type>(r, xr, b, ar);
+            xl = l; xr = r;
+            al = a; ar = b;
+        } else {
+            yn[i] = shape<type>(l);
+            yn[i+1] = shape<type>(r);
+        }
+    }
+}
+
+typedef void (*process_fptr)(const float *xn, float *yn, uint32_t frames, float gain, float *x1);
+
+// [adaa][kernel], the table curves share one kernel when they are built
+// in, the ADAA row is only there with DISTORT_ADAA_KERNELS
+#define k_num_kernels (k_type_table + DISTORT_CURVES)
+
+static const process_fptr s_process[1 + DISTORT_ADAA_KERNELS][k_num_kernels] = {
+    {
+        process<k_type_soft, false>,
+        process<k_type_hard, false>,
+        process<k_type_wrap, false>,
+        process<k_type_fold, false>,
+#if DISTORT_CURVES
+        process<k_type_table, false>,
+#endif
+    },
+#if DISTORT_ADAA_KERNELS
+    {
+        process<k_type_soft, true>,
+        process<k_type_hard, true>,
+        process<k_type_wrap, true>,
+        process<k_type_fold, true>,
+#if DISTORT_CURVES
+        process<k_type_table, true>,
+#endif
+    },
+#endif
+};
+
+// y = x * g over frames of interleaved L/R, g moving by inc per frame
+static void ramp_frames(const float *xn, float *yn, uint32_t frames, float g, const float inc)
+{
+    for (uint32_t i = 0; i < 2 * frames; i += 2) {
+        yn[i] = xn[i] * g;
+        yn[i+1] = xn[i+1] * g;
+        g += inc;
+    }
+}
+
+// One bus through the kernel. A moving gain is ramped into yn first and the
+// kernel runs in place on it, a level other than 1 is ramped onto the
+// output after. A settled depth with the sync off is the kernel alone.
+static void process_bus(const process_fptr process, const float *xn, float *yn, uint32_t frames,
+                        const Ramp &rp, float *x1)
+{
+    if (rp.gain_inc != 0.f) {
+        ramp_frames(xn, yn, frames, rp.gain, rp.gain_inc);
+        process(yn, yn, frames, 1.f, x1);
+    } else {
+        process(xn, yn, frames, rp.gain, x1);
+    }
+    if (rp.level != 1.f || rp.level_inc != 0.f) {
+        ramp_frames(yn, yn, frames, rp.level, rp.level_inc);
+    }
+}
+
+void distort_set_adaa(uint32_t on)
+{
+#if DISTORT_ADAA_KERNELS
+    s_adaa = (on != 0);
+#endif
+}
+
+void distort_set_curve(uint32_t curve)
+{
+#if DISTORT_CURVES
+    s_curve = (curve <= k_num_types - k_type_table) ? curve : 0;
+    lut_select(s_curve);
+#endif
+}
+
+void distort_set_silence(float threshold)
+{
+    s_silence = (threshold > 0.f) ? threshold : 0.f;
+}
+
+const distort_stats_t * distort_stats(void)
+{
+    return &s_stats;
+}
+
+void distort_set_sync(float beats, float depth, float threshold)
+{
+    s_sync.beats = (beats > 0.f) ? beats : 0.f;
+    s_sync.depth = clip01f(depth);
+    s_sync.threshold = clip01f(threshold);
 }
 
 void MODFX_INIT(uint32_t platform, uint32_t api)
 {
-    dist_depth = 1.f;
+    smooth_init(dist_depth, 1.f);
     dist_type = 01.f;
+    // The prologue runs the effect on both timbres, the NTS-1 has no sub
+    // bus and ignores sub_yn
+    s_has_sub = (platform & USER_TARGET_PLATFORM_MASK) != k_user_target_nutektdigital;
+    for (int c = 0; c < 4; c++) {
+        s_adaa_x1[c] = 0.f;
+    }
+#if DISTORT_CURVES
+    lut_select(s_curve);
+#endif
+    s_sync.phase = 0.f;
+    s_quiet = 0;
+    s_bypass = false;
+    s_stats.blocks = 0;
+    s_stats.bypassed_blocks = 0;
+    s_stats.bypassed = 0;
+}
+
+// Whether every sample of an interleaved stereo block is below level. A
+// signal is found on its first loud sample, only quiet blocks are read
+// through.
+static bool block_below(const float *xn, uint32_t frames, const float level)
+{
+    for (uint32_t i = 0; i < 2 * frames; i++) {
+        if (fabsf(xn[i]) >= level) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void MODFX_PROCESS(const float *main_xn, float *main_yn,
                    const float *sub_xn,  float *sub_yn,
                    uint32_t frames)
 {
-    const float tempo = fx_get_bpmf();
-    const float * mx = main_xn;
-    float * __restrict my = main_yn;
-    const float * my_e = my + 2*frames;
-
-    const float *sx = sub_xn;
-    float * __restrict sy = sub_yn;
-    float base_main;
-    float base_sub;
-    for (; my < my_e;) {
-        base_main = *(mx++) * ((dist_depth * 10.0f) + 1.f);
-        base_sub = *(sx++) * ((dist_depth * 10.0f) + 1.f);
-        switch(dist_type) {
-            case 0:
-                *(my++) = softclip(base_main, 0.15f, 0.15f);
-                *(sy++) = softclip(base_sub, 0.15f, 0.15f);
-                break;
-            case 1:
-                *(my++) = hardclip(base_main, 0.15f);
-                *(sy++) = hardclip(base_sub, 0.15f);
-                break;
-            case 2:
-                *(my++) = wrap(base_main, 0.15f);
-                *(sy++) = wrap(base_sub, 0.15f);
-                break;
-            case 3:
-                *(my++) = fold(base_main, 0.15f);
-                *(sy++) = fold(base_sub, 0.15f);
-                break;
+    if (frames == 0) {
+        return;
+    }
+    // The tempo sync is followed at control rate: the modulator is taken at
+    // both ends of the block and the kernels ramp between them. It is a
+    // falling ramp over the period, each beat hits hard and then eases off.
+    // The block that holds the wrap ramps back up, a one block attack.
+    // The smoothed depth knob adds its own ramp under it.
+    float d0;
+    const float d_inc = smooth_block(dist_depth, frames, d0);
+    const float d1 = d0 + d_inc * frames;
+    float depth0 = d0;
+    float depth1 = d1;
+    float k0 = 1.f;
+    float k1 = 1.f;
+    if (s_sync.beats > 0.f) {
+        const float m0 = 1.f - s_sync.phase;
+        s_sync.phase += frames * fx_get_bpmf() * (1.f / (60.f * k_samplerate)) / s_sync.beats;
+        s_sync.phase -= (uint32_t)s_sync.phase;
+        const float m1 = 1.f - s_sync.phase;
+        depth0 = clip01f(d0 + s_sync.depth * m0);
+        depth1 = clip01f(d1 + s_sync.depth * m1);
+        k0 = 1.f - 0.75f * s_sync.threshold * m0;
+        k1 = 1.f - 0.75f * s_sync.threshold * m1;
+    }
+    const float frames_recip = 1.f / frames;
+    Ramp rp;
+    rp.gain = ((depth0 * 10.0f) + 1.f) / k0;
+    rp.gain_inc = (((depth1 * 10.0f) + 1.f) / k1 - rp.gain) * frames_recip;
+    rp.level = k0;
+    rp.level_inc = (k1 - k0) * frames_recip;
+
+    // Silent input is not shaped. Blocks go quiet once the peak of main
+    // (and sub) has stayed below s_silence for DISTORT_SILENCE_HOLD frames,
+    // and wake up as soon as it reaches twice that, so a signal sitting
+    // at the threshold does not flap. Every shaper maps 0 to 0, the output
+    // is written as silence and the ADAA history starts from 0 again,
+    // which is what the kernel would have given to within the threshold
+    // times the gain. The ramps and the sync above move on regardless.
+    s_stats.blocks++;
+    if (s_silence > 0.f) {
+        const float level = s_bypass ? 2.f * s_silence : s_silence;
+        const bool below = block_below(main_xn, frames, level)
+            && (!s_has_sub || block_below(sub_xn, frames, level));
+        if (s_bypass) {
+            if (!below) {
+                s_bypass = false;
+                s_quiet = 0;
+            }
+        } else if (below) {
+            s_quiet += frames;
+            if (s_quiet >= DISTORT_SILENCE_HOLD) {
+                s_bypass = true;
+                for (int c = 0; c < 4; c++) {
+                    s_adaa_x1[c] = 0.f;
+                }
+            }
+        } else {
+            s_quiet = 0;
         }
+    } else {
+        s_bypass = false;
+        s_quiet = 0;
+    }
+    s_stats.bypassed = s_bypass;
+    if (s_bypass) {
+        s_stats.bypassed_blocks++;
+        for (uint32_t i = 0; i < 2 * frames; i++) {
+            main_yn[i] = 0.f;
+        }
+        if (s_has_sub) {
+            for (uint32_t i = 0; i < 2 * frames; i++) {
+                sub_yn[i] = 0.f;
+            }
+        }
+        return;
+    }
 
+    // Clip type is constant for the block, pick the kernel once. A table
+    // curve, when one is selected, takes over from the time knob.
+    int type = dist_type;
+#if DISTORT_CURVES
+    if (s_curve) {
+        type = k_type_table;
+    }
+#endif
+    const process_fptr process = s_process[s_adaa][type];
+    process_bus(process, main_xn, main_yn, frames, rp, &s_adaa_x1[0]);
+    if (s_has_sub) {
+        process_bus(process, sub_xn, sub_yn, frames, rp, &s_adaa_x1[2]);
     }
 }
 
@@ -104,7 +736,7 @@ void MODFX_PARAM(uint8_t index, int32_t value)
                 }
                 break;
             case k_user_modfx_param_depth:
-                dist_depth = valf;
+                smooth_set(dist_depth, valf);
                 break;
             default:
                 break;
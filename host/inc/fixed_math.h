@@ -0,0 +1,64 @@
+/*
+ * File: fixed_math.h
+ *
+ * Host shim of the logue-sdk fixed point helpers.
+ * Saturating operations are emulated with 64 bit arithmetic in place of the
+ * Cortex-M4 QADD/QSUB/SSAT instructions.
+ *
+ */
+
+#ifndef __fixed_math_h
+#define __fixed_math_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int8_t  q7_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+#define Q31_MAX (0x7FFFFFFF)
+#define Q31_MIN (-0x7FFFFFFF - 1)
+
+#define q31_to_f32_c 4.65661287307739e-010f
+#define q31_to_f32(q) ((float)(q) * q31_to_f32_c)
+
+// The M4 VCVT saturates on overflow while x86 CVTTSS2SI returns INT_MIN, so
+// clamp here to keep host output identical to the target.
+static inline __attribute__((always_inline))
+q31_t f32_to_q31_sat(const float f) {
+  const float x = f * (float)0x7FFFFFFF;
+  return (x >= 2147483647.f) ? Q31_MAX : (x <= -2147483648.f) ? Q31_MIN : (q31_t)x;
+}
+
+#define f32_to_q31(f)   f32_to_q31_sat((float)(f))
+
+static inline __attribute__((always_inline))
+q31_t q31sat(const q63_t x) {
+  return (x > Q31_MAX) ? Q31_MAX : (x < Q31_MIN) ? Q31_MIN : (q31_t)x;
+}
+
+static inline __attribute__((always_inline))
+q31_t q31add(const q31_t op1, const q31_t op2) {
+  return q31sat((q63_t)op1 + op2);
+}
+
+static inline __attribute__((always_inline))
+q31_t q31sub(const q31_t op1, const q31_t op2) {
+  return q31sat((q63_t)op1 - op2);
+}
+
+static inline __attribute__((always_inline))
+q31_t q31mul(const q31_t op1, const q31_t op2) {
+  return (q31_t)(((q63_t)op1 * op2) >> 31);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __fixed_math_h
@@ -0,0 +1,129 @@
+/*
+ * File: float_math.h
+ *
+ * Host shim of the logue-sdk float math helpers.
+ * Only the subset used by the units in this repository is provided.
+ *
+ */
+
+#ifndef __float_math_h
+#define __float_math_h
+
+#include <stdint.h>
+#include <math.h>
+
+#ifndef __fast_inline
+#define __fast_inline static inline __attribute__((always_inline, optimize("Ofast")))
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+#ifndef M_TWOPI
+#define M_TWOPI 6.28318530717958647692
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef union {
+  float f;
+  uint32_t i;
+} f32_u32_t;
+
+__fast_inline float si_fabsf(float x) {
+  f32_u32_t u = { x };
+  u.i &= 0x7FFFFFFF;
+  return u.f;
+}
+
+__fast_inline float si_copysignf(const float x, const float y) {
+  f32_u32_t ux = { x };
+  f32_u32_t uy = { y };
+  ux.i = (ux.i & 0x7FFFFFFF) | (uy.i & 0x80000000);
+  return ux.f;
+}
+
+__fast_inline float clipmaxf(const float x, const float m) {
+  return (x >= m) ? m : x;
+}
+
+__fast_inline float clipminf(const float m, const float x) {
+  return (x <= m) ? m : x;
+}
+
+__fast_inline float clipminmaxf(const float min, const float x, const float max) {
+  return (x >= max) ? max : (x <= min) ? min : x;
+}
+
+__fast_inline float clip0f(const float x) {
+  return (x < 0.f) ? 0.f : x;
+}
+
+__fast_inline float clip1f(const float x) {
+  return (x > 1.f) ? 1.f : x;
+}
+
+__fast_inline float clip01f(const float x) {
+  return (x > 1.f) ? 1.f : (x < 0.f) ? 0.f : x;
+}
+
+__fast_inline float clip1m1f(const float x) {
+  return (x > 1.f) ? 1.f : (x < -1.f) ? -1.f : x;
+}
+
+__fast_inline float linintf(const float fr, const float x0, const float x1) {
+  return x0 + fr * (x1 - x0);
+}
+
+__fast_inline float fastlog2f(float x) {
+  f32_u32_t vx = { x };
+  f32_u32_t mx;
+  mx.i = (vx.i & 0x007FFFFF) | 0x3f000000;
+  float y = (float)vx.i;
+  y *= 1.1920928955078125e-7f;
+  return y - 124.22551499f - 1.498030302f * mx.f - 1.72587999f / (0.3520887068f + mx.f);
+}
+
+__fast_inline float fasterlog2f(float x) {
+  f32_u32_t vx = { x };
+  float y = (float)vx.i;
+  y *= 1.1920928955078125e-7f;
+  return y - 126.94269504f;
+}
+
+__fast_inline float fastlogf(float x) {
+  return 0.69314718f * fastlog2f(x);
+}
+
+__fast_inline float fastpow2f(float p) {
+  const float offset = (p < 0) ? 1.0f : 0.0f;
+  const float clipp = (p < -126) ? -126.0f : p;
+  const int w = (int)clipp;
+  const float z = clipp - w + offset;
+  f32_u32_t v;
+  v.i = (uint32_t)((1 << 23) * (clipp + 121.2740575f + 27.7280233f / (4.84252568f - z) - 1.49012907f * z));
+  return v.f;
+}
+
+__fast_inline float fasterpow2f(float p) {
+  const float clipp = (p < -126) ? -126.0f : p;
+  f32_u32_t v;
+  v.i = (uint32_t)((1 << 23) * (clipp + 126.94269504f));
+  return v.f;
+}
+
+__fast_inline float fastexpf(float p) {
+  return fastpow2f(1.442695040f * p);
+}
+
+__fast_inline float fasterexpf(float p) {
+  return fasterpow2f(1.442695040f * p);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __float_math_h
@@ -0,0 +1,76 @@
+/*
+ * File: fx_api.h
+ *
+ * Host shim of the logue-sdk effect runtime API.
+ * The tempo returned by fx_get_bpm()/fx_get_bpmf() is set by the host driver
+ * through fx_host_set_bpmf().
+ *
+ */
+
+#ifndef __fx_api_h
+#define __fx_api_h
+
+#include <stdint.h>
+
+#include "float_math.h"
+#include "int_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define k_samplerate        (48000)
+#define k_samplerate_recipf (2.08333333333333e-005f)
+
+#define k_wt_sine_size_exp     (7)
+#define k_wt_sine_size         (1U<<k_wt_sine_size_exp)
+#define k_wt_sine_mask         (k_wt_sine_size-1)
+#define k_wt_sine_lut_size     (k_wt_sine_size+1)
+
+extern const float wt_sine_lut_f[k_wt_sine_lut_size];
+
+__fast_inline float fx_sinf(float x) {
+  const float p = x - (uint32_t)x;
+  const float x0f = 2.f * p * k_wt_sine_size;
+  const uint32_t x0p = (uint32_t)x0f;
+  const uint32_t x0 = x0p & k_wt_sine_mask;
+  const uint32_t x1 = (x0 + 1) & k_wt_sine_mask;
+  const float y0 = linintf(x0f - x0p, wt_sine_lut_f[x0], wt_sine_lut_f[x1]);
+  return (x0p < k_wt_sine_size) ? y0 : -y0;
+}
+
+__fast_inline float fx_cosf(float x) {
+  return fx_sinf(x + 0.25f);
+}
+
+uint32_t _fx_rand(void);
+float _fx_white(void);
+uint16_t _fx_get_bpm(void);
+float _fx_get_bpmf(void);
+
+__fast_inline uint32_t fx_rand(void) {
+  return _fx_rand();
+}
+
+__fast_inline float fx_white(void) {
+  return _fx_white();
+}
+
+/** Current tempo in tenths of BPM. */
+__fast_inline uint16_t fx_get_bpm(void) {
+  return _fx_get_bpm();
+}
+
+/** Current tempo in BPM. */
+__fast_inline float fx_get_bpmf(void) {
+  return _fx_get_bpmf();
+}
+
+/** Host only: set the tempo reported to the effect. */
+void fx_host_set_bpmf(float bpm);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __fx_api_h
@@ -0,0 +1,46 @@
+/*
+ * File: int_math.h
+ *
+ * Host shim of the logue-sdk integer math helpers.
+ *
+ */
+
+#ifndef __int_math_h
+#define __int_math_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline __attribute__((always_inline))
+uint32_t clipmaxu32(const uint32_t x, const uint32_t m) {
+  return (x >= m) ? m : x;
+}
+
+static inline __attribute__((always_inline))
+uint32_t clipminu32(const uint32_t m, const uint32_t x) {
+  return (x <= m) ? m : x;
+}
+
+static inline __attribute__((always_inline))
+int32_t clipmaxi32(const int32_t x, const int32_t m) {
+  return (x >= m) ? m : x;
+}
+
+static inline __attribute__((always_inline))
+int32_t clipmini32(const int32_t m, const int32_t x) {
+  return (x <= m) ? m : x;
+}
+
+static inline __attribute__((always_inline))
+int32_t clipminmaxi32(const int32_t min, const int32_t x, const int32_t max) {
+  return (x >= max) ? max : (x <= min) ? min : x;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __int_math_h
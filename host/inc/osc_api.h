@@ -0,0 +1,196 @@
+/*
+ * File: osc_api.h
+ *
+ * Host shim of the logue-sdk oscillator runtime API.
+ * The lookup tables are generated at startup by host/src/osc_api.cpp with the
+ * same sizes and layout as the ones exported by osc_api.syms.
+ *
+ */
+
+#ifndef __osc_api_h
+#define __osc_api_h
+
+#include <stdint.h>
+
+#include "float_math.h"
+#include "int_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define k_samplerate        (48000)
+#define k_samplerate_recipf (2.08333333333333e-005f)
+
+/*===========================================================================*/
+/* Pitch / Frequency                                                         */
+/*===========================================================================*/
+
+#define k_midi_to_hz_size   (152)
+#define k_note_mod_fscale   (0.00392156862745098f)
+#define k_note_max_hz       (23679.643054f)
+
+extern const float midi_to_hz_lut_f[k_midi_to_hz_size];
+
+__fast_inline float osc_notehzf(uint8_t note) {
+  return midi_to_hz_lut_f[clipmaxu32(note, k_midi_to_hz_size-1)];
+}
+
+__fast_inline float osc_w0f_for_note(uint8_t note, uint8_t mod) {
+  const float f0 = osc_notehzf(note);
+  const float f1 = osc_notehzf(note+1);
+  const float f = clipmaxf(linintf(mod * k_note_mod_fscale, f0, f1), k_note_max_hz);
+  return f * k_samplerate_recipf;
+}
+
+/*===========================================================================*/
+/* Waves                                                                     */
+/*===========================================================================*/
+
+#define k_wt_sine_size_exp     (7)
+#define k_wt_sine_size         (1U<<k_wt_sine_size_exp)
+#define k_wt_sine_mask         (k_wt_sine_size-1)
+#define k_wt_sine_lut_size     (k_wt_sine_size+1)
+
+extern const float wt_sine_lut_f[k_wt_sine_lut_size];
+
+/** Sine lookup. Half a period is stored, the second half is mirrored.
+ * @param x Phase in [0, 1.0).
+ */
+__fast_inline float osc_sinf(float x) {
+  const float p = x - (uint32_t)x;
+  const float x0f = 2.f * p * k_wt_sine_size;
+  const uint32_t x0p = (uint32_t)x0f;
+  const uint32_t x0 = x0p & k_wt_sine_mask;
+  const uint32_t x1 = (x0 + 1) & k_wt_sine_mask;
+  const float y0 = linintf(x0f - x0p, wt_sine_lut_f[x0], wt_sine_lut_f[x1]);
+  return (x0p < k_wt_sine_size) ? y0 : -y0;
+}
+
+__fast_inline float osc_cosf(float x) {
+  return osc_sinf(x + 0.25f);
+}
+
+#define k_wt_saw_size_exp      (7)
+#define k_wt_saw_size          (1U<<k_wt_saw_size_exp)
+#define k_wt_saw_mask          (k_wt_saw_size-1)
+#define k_wt_saw_lut_size      (k_wt_saw_size+1)
+#define k_wt_saw_notes_cnt     (7)
+#define k_wt_saw_lut_tsize     (k_wt_saw_notes_cnt * k_wt_saw_lut_size)
+
+extern const uint8_t wt_saw_notes[k_wt_saw_notes_cnt];
+extern const float wt_saw_lut_f[k_wt_saw_lut_tsize];
+
+/** Band-limited saw lookup.
+ * @param x   Phase in [0, 1.0).
+ * @param idx Table index in [0, k_wt_saw_notes_cnt-1], 0 being the richest.
+ */
+__fast_inline float osc_bl_sawf(float x, uint8_t idx) {
+  const float p = x - (uint32_t)x;
+  const float x0f = 2.f * p * k_wt_saw_size;
+  const uint32_t x0p = (uint32_t)x0f;
+  uint32_t x0 = x0p, x1 = x0p+1;
+  float sign = 1.f;
+  if (x0p >= k_wt_saw_size) {
+    x0 = k_wt_saw_size - (x0p & k_wt_saw_mask);
+    x1 = x0 - 1;
+    sign = -1.f;
+  }
+  const float * const wt = &wt_saw_lut_f[idx * k_wt_saw_lut_size];
+  const float y0 = linintf(x0f - x0p, wt[x0], wt[x1]);
+  return sign * y0;
+}
+
+__fast_inline float osc_sawf(float x) {
+  return osc_bl_sawf(x, 0);
+}
+
+#define k_wt_sqr_size_exp      (7)
+#define k_wt_sqr_size          (1U<<k_wt_sqr_size_exp)
+#define k_wt_sqr_mask          (k_wt_sqr_size-1)
+#define k_wt_sqr_lut_size      (k_wt_sqr_size+1)
+#define k_wt_sqr_notes_cnt     (7)
+#define k_wt_sqr_lut_tsize     (k_wt_sqr_notes_cnt * k_wt_sqr_lut_size)
+
+extern const uint8_t wt_sqr_notes[k_wt_sqr_notes_cnt];
+extern const float wt_sqr_lut_f[k_wt_sqr_lut_tsize];
+
+/** Band-limited square lookup.
+ * @param x   Phase in [0, 1.0).
+ * @param idx Table index in [0, k_wt_sqr_notes_cnt-1], 0 being the richest.
+ */
+__fast_inline float osc_bl_sqrf(float x, uint8_t idx) {
+  const float p = x - (uint32_t)x;
+  const float x0f = 2.f * p * k_wt_sqr_size;
+  const uint32_t x0p = (uint32_t)x0f;
+  uint32_t x0 = x0p, x1 = x0p+1;
+  float sign = 1.f;
+  if (x0p >= k_wt_sqr_size) {
+    x0 = k_wt_sqr_size - (x0p & k_wt_sqr_mask);
+    x1 = x0 - 1;
+    sign = -1.f;
+  }
+  const float * const wt = &wt_sqr_lut_f[idx * k_wt_sqr_lut_size];
+  const float y0 = linintf(x0f - x0p, wt[x0], wt[x1]);
+  return sign * y0;
+}
+
+__fast_inline float osc_sqrf(float x) {
+  return osc_bl_sqrf(x, 0);
+}
+
+/** Fractional table index for a given note, in [0, k_wt_*_notes_cnt-1]. */
+float _osc_bl_saw_idx(float note);
+float _osc_bl_sqr_idx(float note);
+
+__fast_inline float osc_bl_saw_idx(float note) {
+  return _osc_bl_saw_idx(note);
+}
+
+__fast_inline float osc_bl_sqr_idx(float note) {
+  return _osc_bl_sqr_idx(note);
+}
+
+__fast_inline float osc_bl2_sawf(float x, float idx) {
+  const float fr = idx - (uint8_t)idx;
+  const uint8_t i0 = (uint8_t)idx;
+  const uint8_t i1 = clipmaxu32(i0 + 1, k_wt_saw_notes_cnt - 1);
+  return linintf(fr, osc_bl_sawf(x, i0), osc_bl_sawf(x, i1));
+}
+
+__fast_inline float osc_bl2_sqrf(float x, float idx) {
+  const float fr = idx - (uint8_t)idx;
+  const uint8_t i0 = (uint8_t)idx;
+  const uint8_t i1 = clipmaxu32(i0 + 1, k_wt_sqr_notes_cnt - 1);
+  return linintf(fr, osc_bl_sqrf(x, i0), osc_bl_sqrf(x, i1));
+}
+
+/*===========================================================================*/
+/* Saturation                                                                */
+/*===========================================================================*/
+
+__fast_inline float osc_softclipf(const float c, float x) {
+  x = clip1m1f(x);
+  return x - c * (x*x*x);
+}
+
+/*===========================================================================*/
+/* Noise                                                                     */
+/*===========================================================================*/
+
+uint32_t _osc_rand(void);
+float _osc_white(void);
+
+__fast_inline uint32_t osc_rand(void) {
+  return _osc_rand();
+}
+
+__fast_inline float osc_white(void) {
+  return _osc_white();
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __osc_api_h
@@ -0,0 +1,51 @@
+/*
+ * File: usermodfx.h
+ *
+ * Host shim of the logue-sdk user modulation effect interface.
+ *
+ */
+
+#ifndef __usermodfx_h
+#define __usermodfx_h
+
+#include <stdint.h>
+
+#include "userprg.h"
+#include "float_math.h"
+#include "int_math.h"
+#include "fixed_math.h"
+#include "fx_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  k_user_modfx_param_time = 0,
+  k_user_modfx_param_depth,
+  k_num_user_modfx_param_id
+} user_modfx_param_id_t;
+
+#define MODFX_INIT    __attribute__((used)) _hook_init
+#define MODFX_PROCESS __attribute__((used)) _hook_process
+#define MODFX_SUSPEND __attribute__((used)) _hook_suspend
+#define MODFX_RESUME  __attribute__((used)) _hook_resume
+#define MODFX_PARAM   __attribute__((used)) _hook_param
+
+// The host tools link every unit into one binary and include both
+// interfaces, so they opt out of the unprefixed prototypes.
+#ifndef USER_HOST_REGISTRY
+void _hook_init(uint32_t platform, uint32_t api);
+void _hook_process(const float *main_xn, float *main_yn,
+                   const float *sub_xn,  float *sub_yn,
+                   uint32_t frames);
+void _hook_suspend(void);
+void _hook_resume(void);
+void _hook_param(uint8_t index, int32_t value);
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __usermodfx_h
@@ -0,0 +1,73 @@
+/*
+ * File: userosc.h
+ *
+ * Host shim of the logue-sdk user oscillator interface.
+ *
+ */
+
+#ifndef __userosc_h
+#define __userosc_h
+
+#include <stdint.h>
+
+#include "userprg.h"
+#include "float_math.h"
+#include "int_math.h"
+#include "fixed_math.h"
+#include "osc_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct user_osc_param {
+  /** Value of LFO implicitly applied to shape parameter */
+  int32_t  shape_lfo;
+  /** Current pitch. high byte: note number, low byte: fine (0-255) */
+  uint16_t pitch;
+  /** Current cutoff value (0x0000-0x1fff) */
+  uint16_t cutoff;
+  /** Current resonance value (0x0000-0x1fff) */
+  uint16_t resonance;
+  uint16_t reserved0[3];
+} user_osc_param_t;
+
+typedef enum {
+  k_user_osc_param_id1 = 0,
+  k_user_osc_param_id2,
+  k_user_osc_param_id3,
+  k_user_osc_param_id4,
+  k_user_osc_param_id5,
+  k_user_osc_param_id6,
+  k_user_osc_param_shape,
+  k_user_osc_param_shiftshape,
+  k_num_user_osc_param_id
+} user_osc_param_id_t;
+
+#define param_val_to_f32(val) ((uint16_t)val * 9.77517106549365e-004f)
+
+#define OSC_INIT    __attribute__((used)) _hook_init
+#define OSC_CYCLE   __attribute__((used)) _hook_cycle
+#define OSC_NOTEON  __attribute__((used)) _hook_on
+#define OSC_NOTEOFF __attribute__((used)) _hook_off
+#define OSC_MUTE    __attribute__((used)) _hook_mute
+#define OSC_VALUE   __attribute__((used)) _hook_value
+#define OSC_PARAM   __attribute__((used)) _hook_param
+
+// The host tools link every unit into one binary and include both
+// interfaces, so they opt out of the unprefixed prototypes.
+#ifndef USER_HOST_REGISTRY
+void _hook_init(uint32_t platform, uint32_t api);
+void _hook_cycle(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames);
+void _hook_on(const user_osc_param_t * const params);
+void _hook_off(const user_osc_param_t * const params);
+void _hook_mute(const user_osc_param_t * const params);
+void _hook_value(uint16_t value);
+void _hook_param(uint16_t index, uint16_t value);
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __userosc_h
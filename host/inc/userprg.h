@@ -0,0 +1,36 @@
+/*
+ * File: userprg.h
+ *
+ * Host shim of the logue-sdk user program definitions.
+ *
+ */
+
+#ifndef __userprg_h
+#define __userprg_h
+
+#include <stdint.h>
+
+enum {
+  k_user_target_prologue      = (1U<<8),
+  k_user_target_miniloguexd   = (2U<<8),
+  k_user_target_nutektdigital = (3U<<8),
+};
+
+#define USER_TARGET_PLATFORM_MASK (0x7F<<8)
+#define USER_TARGET_MODULE_MASK   (0x7F)
+
+enum {
+  k_user_module_global = 0,
+  k_user_module_modfx,
+  k_user_module_delfx,
+  k_user_module_revfx,
+  k_user_module_osc,
+};
+
+#ifndef USER_TARGET_PLATFORM
+#define USER_TARGET_PLATFORM k_user_target_nutektdigital
+#endif
+
+#define USER_API_VERSION ((1U<<16) | (1U<<8) | 0U)
+
+#endif // __userprg_h
@@ -0,0 +1,578 @@
+/*
+ * File: bench.cpp
+ *
+ * Micro-benchmark of the unit hooks across their parameter space.
+ *
+ * Every case is timed over several runs of back to back cycle/process calls
+ * and the fastest run is kept. Results are written as JSON so that runs can
+ * be diffed:
+ *
+ *   { "samplerate": 48000, "results": [
+ *     { "unit": "chords-osc", "case": { ... }, "frames": 64,
+ *       "ns_per_frame": 12.3, "frames_per_s": 8.1e7, "realtime_pct": 0.06 },
+ *     ... ] }
+ *
+ * realtime_pct is the share of the 48 kHz real-time budget (20.8 us per
+ * frame) used by the hook on this host.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "units.h"
+#include "chords-osc/chords.h"
+#include "distort-mod/distort.h"
+#include "common/output_stage.h"
+
+#define k_max_block  (64)
+#define k_input_size (4096)
+
+typedef struct BenchOpts {
+  double min_ms;     // minimum duration of one timed run
+  uint32_t runs;     // timed runs per case, the fastest is kept
+  const char *unit;  // only run cases of this unit if not NULL
+} BenchOpts;
+
+static BenchOpts s_opts = { 20.0, 5, NULL };
+static FILE *s_out;
+static bool s_first = true;
+
+static float s_input[2 * k_input_size];
+// Full scale square, the worst case of shapers whose cost grows with the
+// level
+static float s_input_hot[2 * k_input_size];
+// The saw for the first half and silence for the second, notes with gaps
+// as in a sparse live set
+static float s_input_gated[2 * k_input_size];
+
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static bool unit_enabled(const char *name)
+{
+  return (s_opts.unit == NULL) || (strcmp(s_opts.unit, name) == 0);
+}
+
+// extra, if not NULL, holds additional "key": value pairs for the result
+static void report(const char *unit, const char *json_case, uint32_t frames, double ns_per_frame,
+                   const char *extra = NULL)
+{
+  const double frame_ns = 1e9 / k_samplerate;
+  fprintf(s_out, "%s\n    { \"unit\": \"%s\", \"case\": { %s }, \"frames\": %u, "
+          "\"ns_per_frame\": %.3f, \"frames_per_s\": %.0f, \"realtime_pct\": %.4f%s%s }",
+          s_first ? "" : ",", unit, json_case, frames,
+          ns_per_frame, 1e9 / ns_per_frame, 100.0 * ns_per_frame / frame_ns,
+          extra ? ", " : "", extra ? extra : "");
+  s_first = false;
+  fprintf(stderr, "%-12s %-48s %2u frames %9.3f ns/frame\n", unit, json_case, frames, ns_per_frame);
+}
+
+/*===========================================================================*/
+/* Oscillators                                                               */
+/*===========================================================================*/
+
+typedef struct OscParam {
+  uint16_t index;
+  uint16_t value;
+} OscParam;
+
+// lfo_hz, if not 0, runs the shape LFO as a full depth sine, updated once
+// per cycle as on the hardware
+static double time_osc(const host_unit_t *unit, const OscParam *setup, uint32_t count,
+                       uint16_t pitch, uint32_t frames, float lfo_hz = 0.f)
+{
+  user_osc_param_t params;
+  memset(&params, 0, sizeof(params));
+  params.pitch = pitch;
+
+  unit->osc.func_init(k_user_target_nutektdigital, USER_API_VERSION);
+  for (uint32_t i = 0; i < count; i++)
+    unit->osc.func_param(setup[i].index, setup[i].value);
+  unit->osc.func_on(&params);
+
+  // One LFO period worth of values, so that the sine is not computed in
+  // the timed loop
+  q31_t lfo[256];
+  const uint32_t lfo_len = (lfo_hz > 0.f) ? clipmaxu32((uint32_t)(k_samplerate / (lfo_hz * frames)), 256) : 1;
+  for (uint32_t i = 0; i < lfo_len; i++)
+    lfo[i] = f32_to_q31((lfo_hz > 0.f) ? sinf(2.f * (float)M_PI * i / lfo_len) : 0.f);
+  uint32_t lfo_pos = 0;
+
+  int32_t yn[k_max_block];
+  // Warm up caches and let one-off state settle.
+  for (uint32_t i = 0; i < 256; i++)
+    unit->osc.func_cycle(&params, yn, frames);
+
+  double best = 1e30;
+  for (uint32_t r = 0; r < s_opts.runs; r++) {
+    uint64_t total = 0;
+    const double t0 = now_ns();
+    double t1;
+    do {
+      for (uint32_t i = 0; i < 64; i++) {
+        params.shape_lfo = lfo[lfo_pos];
+        lfo_pos = (lfo_pos + 1 < lfo_len) ? lfo_pos + 1 : 0;
+        unit->osc.func_cycle(&params, yn, frames);
+      }
+      total += 64 * frames;
+      t1 = now_ns();
+    } while (t1 - t0 < s_opts.min_ms * 1e6);
+    const double ns = (t1 - t0) / total;
+    if (ns < best)
+      best = ns;
+  }
+  return best;
+}
+
+static void bench_chords(void)
+{
+  const host_unit_t *unit = host_unit_find("chords-osc");
+  if (unit == NULL || !unit_enabled(unit->name))
+    return;
+
+  static const char * const waves[3] = { "saw", "square", "sine" };
+  static const uint16_t wave_values[3] = { 0, 50, 100 };
+  static const uint16_t extension_values[5] = { 0, 256, 512, 768, 1023 };
+  static const uint16_t detune_values[2] = { 0, 50 };
+  static const uint32_t frames[4] = { 1, 16, 32, 64 };
+
+  for (int w = 0; w < 3; w++) {
+    for (int e = 0; e < 5; e++) {
+      for (int d = 0; d < 2; d++) {
+        for (int f = 0; f < 4; f++) {
+          const OscParam setup[] = {
+            { k_user_osc_param_id1, wave_values[w] },
+            { k_user_osc_param_id2, detune_values[d] },
+            { k_user_osc_param_shape, 0 },
+            { k_user_osc_param_shiftshape, extension_values[e] },
+          };
+          char json_case[128];
+          snprintf(json_case, sizeof(json_case), "\"wave\": \"%s\", \"extension\": %d, \"detune\": %u",
+                   waves[w], e, detune_values[d]);
+          const double ns = time_osc(unit, setup, sizeof(setup) / sizeof(setup[0]), 48 << 8, frames[f]);
+          const chords_stats_t *stats = chords_stats();
+          char extra[128];
+          snprintf(extra, sizeof(extra),
+                   "\"active_voices\": %u, \"w0_cache_hits\": %u, \"w0_cache_misses\": %u",
+                   stats->active_voices, stats->w0_cache_hits, stats->w0_cache_misses);
+          report(unit->name, json_case, frames[f], ns, extra);
+        }
+      }
+    }
+  }
+
+  // Pitch-tracking band-limited tables against the full band ones
+  for (int w = 0; w < 2; w++) {
+    for (int bl = 0; bl < 2; bl++) {
+      const OscParam setup[] = {
+        { k_user_osc_param_id1, wave_values[w] },
+        { k_user_osc_param_id2, 50 },
+        { k_user_osc_param_id3, (uint16_t)bl },
+        { k_user_osc_param_shape, 0 },
+        { k_user_osc_param_shiftshape, 0 },
+      };
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"wave\": \"%s\", \"extension\": 0, \"detune\": 50, \"bandlimit\": %d",
+               waves[w], bl);
+      const double ns = time_osc(unit, setup, sizeof(setup) / sizeof(setup[0]), 72 << 8, k_max_block);
+      report(unit->name, json_case, k_max_block, ns);
+    }
+  }
+
+  // Governor under a budget the host cannot meet: host cycles are scaled
+  // to 168 MHz, so a few cycles per frame is already tight
+  static const uint32_t budgets[3] = { 0, 4, 1 };
+
+  for (int e = 0; e < 5; e += 3) {
+    for (int b = 0; b < 3; b++) {
+      const OscParam setup[] = {
+        { k_user_osc_param_id1, 0 },
+        { k_user_osc_param_id2, 50 },
+        { k_user_osc_param_shape, 0 },
+        { k_user_osc_param_shiftshape, extension_values[e] },
+      };
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"wave\": \"saw\", \"extension\": %d, \"detune\": 50, \"budget\": %u",
+               e, budgets[b]);
+      chords_set_budget(budgets[b]);
+      const double ns = time_osc(unit, setup, sizeof(setup) / sizeof(setup[0]), 48 << 8, k_max_block);
+      const chords_stats_t *stats = chords_stats();
+      char extra[128];
+      snprintf(extra, sizeof(extra),
+               "\"active_voices\": %u, \"governor_level\": %u, \"cycles_per_frame\": %u",
+               stats->active_voices, stats->governor_level, stats->cycles_per_frame);
+      report(unit->name, json_case, k_max_block, ns, extra);
+    }
+  }
+  chords_set_budget(CHORDS_BUDGET);
+
+  // Shape LFO at 5 Hz on the key or the detune against a still one
+  static const char * const targets[2] = { "key", "detune" };
+  for (int t = 0; t < 2; t++) {
+    for (int l = 0; l < 2; l++) {
+      const OscParam setup[] = {
+        { k_user_osc_param_id1, 0 },
+        { k_user_osc_param_id2, 50 },
+        { k_user_osc_param_id4, (uint16_t)t },
+        { k_user_osc_param_shape, 0 },
+        { k_user_osc_param_shiftshape, 1023 },
+      };
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"lfo\": \"%s\", \"lfo_hz\": %d", targets[t], 5 * l);
+      const double ns = time_osc(unit, setup, sizeof(setup) / sizeof(setup[0]), 48 << 8, k_max_block, 5.f * l);
+      report(unit->name, json_case, k_max_block, ns);
+    }
+  }
+}
+
+static void bench_808(void)
+{
+  const host_unit_t *unit = host_unit_find("osc-808");
+  if (unit == NULL || !unit_enabled(unit->name))
+    return;
+
+  static const float levels[3] = { 0.f, 0.5f, 1.f };
+
+  for (int d = 0; d < 3; d++) {
+    for (int v = 0; v < 3; v++) {
+      for (int p = 0; p < 3; p++) {
+        const OscParam setup[] = {
+          { k_user_osc_param_shiftshape, (uint16_t)(levels[d] * 1023) },
+          { k_user_osc_param_id1, (uint16_t)(levels[v] * 100) },
+          { k_user_osc_param_id2, 20 },
+          { k_user_osc_param_shape, (uint16_t)(levels[p] * 1023) },
+        };
+        char json_case[128];
+        snprintf(json_case, sizeof(json_case), "\"dist\": %.1f, \"drive\": %.1f, \"pitch_decay\": %.1f",
+                 levels[d], levels[v], levels[p]);
+        const double ns = time_osc(unit, setup, sizeof(setup) / sizeof(setup[0]), 36 << 8, k_max_block);
+        report(unit->name, json_case, k_max_block, ns);
+      }
+    }
+  }
+
+  // Oversampled drive and phase distortion against the base rate
+  static const uint8_t factors[3] = { 1, 2, 4 };
+  for (int o = 0; o < 3; o++) {
+    for (int d = 0; d < 3; d++) {
+      const OscParam setup[] = {
+        { k_user_osc_param_shiftshape, (uint16_t)(levels[d] * 1023) },
+        { k_user_osc_param_id1, 100 },
+        { k_user_osc_param_id2, 20 },
+        { k_user_osc_param_id4, (uint16_t)o },
+        { k_user_osc_param_shape, 511 },
+      };
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"oversample\": %u, \"dist\": %.1f", factors[o], levels[d]);
+      const double ns = time_osc(unit, setup, sizeof(setup) / sizeof(setup[0]), 36 << 8, k_max_block);
+      report(unit->name, json_case, k_max_block, ns);
+    }
+  }
+
+  // Shape LFO at 5 Hz on the phase distortion against a still one
+  for (int l = 0; l < 2; l++) {
+    const OscParam setup[] = {
+      { k_user_osc_param_shiftshape, 511 },
+      { k_user_osc_param_id1, 50 },
+      { k_user_osc_param_id2, 20 },
+      { k_user_osc_param_shape, 511 },
+    };
+    char json_case[128];
+    snprintf(json_case, sizeof(json_case), "\"lfo_hz\": %d", 5 * l);
+    const double ns = time_osc(unit, setup, sizeof(setup) / sizeof(setup[0]), 36 << 8, k_max_block, 5.f * l);
+    report(unit->name, json_case, k_max_block, ns);
+  }
+}
+
+static void bench_additive(void)
+{
+  const host_unit_t *unit = host_unit_find("additive-osc");
+  if (unit == NULL || !unit_enabled(unit->name))
+    return;
+
+  static const uint16_t partials[4] = { 8, 16, 32, 64 };
+  // At note 84 only 22 partials are below Nyquist
+  static const uint8_t notes[2] = { 36, 84 };
+
+  for (int n = 0; n < 2; n++) {
+    for (int p = 0; p < 4; p++) {
+      const OscParam setup[] = {
+        { k_user_osc_param_id1, partials[p] },
+        { k_user_osc_param_shape, 341 },
+        { k_user_osc_param_shiftshape, 0 },
+      };
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"partials\": %u, \"note\": %u", partials[p], notes[n]);
+      const double ns = time_osc(unit, setup, sizeof(setup) / sizeof(setup[0]), notes[n] << 8, k_max_block);
+      report(unit->name, json_case, k_max_block, ns);
+    }
+  }
+}
+
+/*===========================================================================*/
+/* Modulation effects                                                        */
+/*===========================================================================*/
+
+static double time_modfx(const host_unit_t *unit, float time, float depth, uint32_t frames,
+                         const float *input = s_input, uint32_t platform = k_user_target_nutektdigital)
+{
+  unit->modfx.func_init(platform, USER_API_VERSION);
+  unit->modfx.func_param(k_user_modfx_param_time, f32_to_q31(time));
+  unit->modfx.func_param(k_user_modfx_param_depth, f32_to_q31(depth));
+
+  float main_yn[2 * k_max_block], sub_yn[2 * k_max_block];
+  uint32_t pos = 0;
+  for (uint32_t i = 0; i < 256; i++) {
+    unit->modfx.func_process(&input[2 * pos], main_yn, &input[2 * pos], sub_yn, frames);
+    pos = (pos + frames) % (k_input_size - k_max_block);
+  }
+
+  double best = 1e30;
+  for (uint32_t r = 0; r < s_opts.runs; r++) {
+    uint64_t total = 0;
+    const double t0 = now_ns();
+    double t1;
+    do {
+      for (uint32_t i = 0; i < 64; i++) {
+        unit->modfx.func_process(&input[2 * pos], main_yn, &input[2 * pos], sub_yn, frames);
+        pos = (pos + frames) % (k_input_size - k_max_block);
+      }
+      total += 64 * frames;
+      t1 = now_ns();
+    } while (t1 - t0 < s_opts.min_ms * 1e6);
+    const double ns = (t1 - t0) / total;
+    if (ns < best)
+      best = ns;
+  }
+  return best;
+}
+
+// Time knob value for type t of bench_distort(). The knob is cut in 4
+// zones and these are their centers, the table curves are selected with
+// distort_set_curve() instead.
+static float distort_type(int t)
+{
+  static const float values[4] = { 0.125f, 0.375f, 0.625f, 0.875f };
+  distort_set_curve((t < 4) ? 0 : t - 3);
+  return values[(t < 4) ? t : 0];
+}
+
+static void bench_distort(void)
+{
+  const host_unit_t *unit = host_unit_find("distort-mod");
+  if (unit == NULL || !unit_enabled(unit->name))
+    return;
+
+  static const char * const types[7] = { "softclip", "hardclip", "wrap", "fold", "tanh", "tube", "diode" };
+  static const float depths[3] = { 0.f, 0.5f, 1.f };
+
+  for (int t = 0; t < 7; t++) {
+    for (int d = 0; d < 3; d++) {
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"dist_type\": \"%s\", \"depth\": %.1f", types[t], depths[d]);
+      const double ns = time_modfx(unit, distort_type(t), depths[d], k_max_block);
+      report(unit->name, json_case, k_max_block, ns);
+    }
+  }
+
+  // Worst case timing: full scale input at full depth
+  for (int t = 0; t < 7; t++) {
+    char json_case[128];
+    snprintf(json_case, sizeof(json_case), "\"dist_type\": \"%s\", \"depth\": 1.0, \"input\": \"fullscale\"", types[t]);
+    const double ns = time_modfx(unit, distort_type(t), 1.f, k_max_block, s_input_hot);
+    report(unit->name, json_case, k_max_block, ns);
+  }
+
+  // Main and sub timbres, as on the prologue, against the NTS-1 main only
+  for (int t = 0; t < 7; t++) {
+    char json_case[128];
+    snprintf(json_case, sizeof(json_case), "\"dist_type\": \"%s\", \"depth\": 1.0, \"platform\": \"prologue\"", types[t]);
+    const double ns = time_modfx(unit, distort_type(t), 1.f, k_max_block, s_input, k_user_target_prologue);
+    report(unit->name, json_case, k_max_block, ns);
+  }
+
+  // Plain shapers against the antiderivative anti-aliased ones
+  for (int a = 0; a < 2; a++) {
+    for (int t = 0; t < 7; t++) {
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"dist_type\": \"%s\", \"depth\": 1.0, \"adaa\": %d", types[t], a);
+      distort_set_adaa(a);
+      const double ns = time_modfx(unit, distort_type(t), 1.f, k_max_block);
+      report(unit->name, json_case, k_max_block, ns);
+    }
+  }
+  distort_set_adaa(DISTORT_ADAA);
+
+  // Fixed depth against the tempo-synced ramps, one beat period
+  for (int y = 0; y < 2; y++) {
+    for (int t = 0; t < 7; t++) {
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"dist_type\": \"%s\", \"depth\": 0.5, \"sync\": %d", types[t], y);
+      distort_set_sync(y ? 1.f : 0.f, 0.5f, 0.5f);
+      const double ns = time_modfx(unit, distort_type(t), 0.5f, k_max_block);
+      report(unit->name, json_case, k_max_block, ns);
+    }
+  }
+  distort_set_sync(DISTORT_SYNC_BEATS, DISTORT_SYNC_DEPTH, DISTORT_SYNC_THRESHOLD);
+
+  // Gated input with the silence bypass off and on
+  for (int b = 0; b < 2; b++) {
+    for (int t = 0; t < 7; t++) {
+      char json_case[128];
+      snprintf(json_case, sizeof(json_case), "\"dist_type\": \"%s\", \"depth\": 1.0, \"input\": \"gated\", \"bypass\": %d",
+               types[t], b);
+      distort_set_silence(b ? DISTORT_SILENCE : 0.f);
+      const double ns = time_modfx(unit, distort_type(t), 1.f, k_max_block, s_input_gated);
+      const distort_stats_t *stats = distort_stats();
+      char extra[128];
+      snprintf(extra, sizeof(extra), "\"blocks\": %u, \"bypassed_blocks\": %u",
+               stats->blocks, stats->bypassed_blocks);
+      report(unit->name, json_case, k_max_block, ns, extra);
+    }
+  }
+  distort_set_silence(DISTORT_SILENCE);
+  distort_set_curve(DISTORT_CURVE);
+}
+
+/*===========================================================================*/
+/* Output stage                                                              */
+/*===========================================================================*/
+
+#define k_output_stage "output-stage"
+
+// Per-sample softclip and conversion as the render loops did it before the
+// shared stage, kept as the reference
+static void output_scalar(q31_t * __restrict y, const float * __restrict x, uint32_t frames, float gain)
+{
+  for (uint32_t i = 0; i < frames; i++)
+    y[i] = f32_to_q31(osc_softclipf(k_output_softclip_c, x[i] * gain));
+}
+
+typedef void (*output_fptr)(q31_t * __restrict y, const float * __restrict x, uint32_t frames, float gain);
+
+static double time_output(output_fptr output, float gain, uint32_t frames)
+{
+  q31_t y[k_max_block];
+  uint32_t pos = 0;
+  double best = 1e30;
+  for (uint32_t r = 0; r < s_opts.runs; r++) {
+    uint64_t total = 0;
+    const double t0 = now_ns();
+    double t1;
+    do {
+      for (uint32_t i = 0; i < 64; i++) {
+        output(y, &s_input[pos], frames, gain);
+        pos = (pos + frames) % (k_input_size - k_max_block);
+      }
+      total += 64 * frames;
+      t1 = now_ns();
+    } while (t1 - t0 < s_opts.min_ms * 1e6);
+    const double ns = (t1 - t0) / total;
+    if (ns < best)
+      best = ns;
+  }
+  // Keep the stores alive
+  volatile q31_t sink = y[0];
+  (void)sink;
+  return best;
+}
+
+static void bench_output(void)
+{
+  if (!unit_enabled(k_output_stage))
+    return;
+
+  static const char * const stages[2] = { "scalar", "block" };
+  static const output_fptr outputs[2] = { output_scalar, output_softclip_q31 };
+  static const float gains[2] = { 1.f, 4.f };
+  static const uint32_t frames[3] = { 1, 16, 64 };
+
+  for (int s = 0; s < 2; s++) {
+    for (int g = 0; g < 2; g++) {
+      for (int f = 0; f < 3; f++) {
+        char json_case[128];
+        snprintf(json_case, sizeof(json_case), "\"stage\": \"%s\", \"gain\": %.1f", stages[s], gains[g]);
+        report(k_output_stage, json_case, frames[f], time_output(outputs[s], gains[g], frames[f]));
+      }
+    }
+  }
+}
+
+/*===========================================================================*/
+/* Main                                                                      */
+/*===========================================================================*/
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: nts1-bench [-u unit] [-t ms] [-r runs] [-o out.json]\n"
+          "  -u unit  only benchmark this unit, or " k_output_stage "\n"
+          "  -t ms    minimum duration of a timed run (default %.0f)\n"
+          "  -r runs  timed runs per case, the fastest is kept (default %u)\n"
+          "  -o file  write JSON to file instead of stdout\n",
+          s_opts.min_ms, s_opts.runs);
+}
+
+int main(int argc, char **argv)
+{
+  const char *out_path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+      s_opts.unit = argv[++i];
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      s_opts.min_ms = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      s_opts.runs = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (s_opts.unit != NULL && host_unit_find(s_opts.unit) == NULL
+      && strcmp(s_opts.unit, k_output_stage) != 0) {
+    fprintf(stderr, "error: unknown unit %s\n", s_opts.unit);
+    return 1;
+  }
+  if (s_opts.runs == 0)
+    s_opts.runs = 1;
+
+  s_out = stdout;
+  if (out_path != NULL && (s_out = fopen(out_path, "w")) == NULL) {
+    fprintf(stderr, "error: cannot write %s\n", out_path);
+    return 1;
+  }
+
+  // Modfx input: a loud saw with some noise on top, hot enough to reach
+  // every branch of the shapers.
+  float phase = 0.f;
+  for (uint32_t i = 0; i < k_input_size; i++) {
+    const float sig = 0.8f * (2.f * phase - 1.f) + 0.1f * _fx_white();
+    s_input[2*i] = s_input[2*i+1] = sig;
+    s_input_hot[2*i] = s_input_hot[2*i+1] = (phase < 0.5f) ? 1.f : -1.f;
+    s_input_gated[2*i] = s_input_gated[2*i+1] = (i < k_input_size / 2) ? sig : 0.f;
+    phase += 110.f * k_samplerate_recipf;
+    phase -= (uint32_t)phase;
+  }
+
+  fprintf(s_out, "{\n  \"samplerate\": %d,\n  \"results\": [", k_samplerate);
+  bench_chords();
+  bench_808();
+  bench_additive();
+  bench_distort();
+  bench_output();
+  fprintf(s_out, "\n  ]\n}\n");
+
+  if (s_out != stdout)
+    fclose(s_out);
+  return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * File: fx_api.cpp
+ *
+ * Host implementation of the effect runtime functions.
+ *
+ */
+
+#include "usermodfx.h"
+
+static uint32_t s_rand_state = 0x87654321;
+static float s_bpm = 120.f;
+
+void fx_host_set_bpmf(float bpm)
+{
+  s_bpm = bpm;
+}
+
+uint16_t _fx_get_bpm(void)
+{
+  return (uint16_t)(s_bpm * 10.f);
+}
+
+float _fx_get_bpmf(void)
+{
+  return s_bpm;
+}
+
+uint32_t _fx_rand(void)
+{
+  // xorshift32
+  uint32_t x = s_rand_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return s_rand_state = x;
+}
+
+float _fx_white(void)
+{
+  return (float)(int32_t)_fx_rand() * 4.65661287307739e-010f;
+}
@@ -0,0 +1,66 @@
+/*
+ * File: luts.cpp
+ *
+ * Runtime lookup tables shared by the oscillator and effect API shims.
+ *
+ * On the target these live in flash at the addresses listed in osc_api.syms
+ * and main_api.syms. Here they are defined without const so that they can be
+ * filled in by a static initializer; the units only see the const
+ * declarations from osc_api.h/fx_api.h.
+ *
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+#define k_midi_to_hz_size   (152)
+#define k_wt_size           (128)
+#define k_wt_lut_size       (k_wt_size+1)
+#define k_wt_notes_cnt      (7)
+
+extern "C" {
+  float midi_to_hz_lut_f[k_midi_to_hz_size];
+  float wt_sine_lut_f[k_wt_lut_size];
+  float wt_saw_lut_f[k_wt_notes_cnt * k_wt_lut_size];
+  float wt_sqr_lut_f[k_wt_notes_cnt * k_wt_lut_size];
+  uint8_t wt_saw_notes[k_wt_notes_cnt] = { 40, 52, 64, 76, 88, 100, 112 };
+  uint8_t wt_sqr_notes[k_wt_notes_cnt] = { 40, 52, 64, 76, 88, 100, 112 };
+}
+
+static double note_hz(double note)
+{
+  return 440.0 * pow(2.0, (note - 69.0) / 12.0);
+}
+
+// Half a period of a band-limited wave, sampled at p = i / (2 * k_wt_size).
+// odd_only selects the square wave series, otherwise a saw is built.
+static void fill_bl_table(float *wt, uint8_t note, bool odd_only)
+{
+  int harmonics = (int)(24000.0 / note_hz(note));
+  if (harmonics > k_wt_size - 1)
+    harmonics = k_wt_size - 1;
+  for (int i = 0; i < k_wt_lut_size; i++) {
+    const double p = (double)i / (2 * k_wt_size);
+    double acc = 0.0;
+    for (int k = 1; k <= harmonics; k += (odd_only ? 2 : 1))
+      acc += sin(2.0 * M_PI * k * p) / k;
+    // Saw rises from -1 to 1 over the period, square is +1 then -1.
+    wt[i] = (float)(odd_only ? (4.0 / M_PI) * acc : -(2.0 / M_PI) * acc);
+  }
+}
+
+namespace {
+  struct LutInit {
+    LutInit() {
+      for (int i = 0; i < k_midi_to_hz_size; i++)
+        midi_to_hz_lut_f[i] = (float)note_hz(i);
+      for (int i = 0; i < k_wt_lut_size; i++)
+        wt_sine_lut_f[i] = (float)sin(M_PI * i / k_wt_size);
+      for (int t = 0; t < k_wt_notes_cnt; t++) {
+        fill_bl_table(&wt_saw_lut_f[t * k_wt_lut_size], wt_saw_notes[t], false);
+        fill_bl_table(&wt_sqr_lut_f[t * k_wt_lut_size], wt_sqr_notes[t], true);
+      }
+    }
+  };
+  LutInit s_lut_init;
+}
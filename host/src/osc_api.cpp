@@ -0,0 +1,48 @@
+/*
+ * File: osc_api.cpp
+ *
+ * Host implementation of the oscillator runtime functions.
+ *
+ */
+
+#include "userosc.h"
+
+static uint32_t s_rand_state = 0x12345678;
+
+static float bl_idx(const uint8_t *notes, uint32_t count, float note)
+{
+  // Fractional index of the first table whose note is at or above the
+  // requested one, so that the selected table never aliases.
+  if (note <= notes[0])
+    return 0.f;
+  for (uint32_t i = 1; i < count; i++) {
+    if (note <= notes[i])
+      return (i - 1) + (note - notes[i-1]) / (float)(notes[i] - notes[i-1]);
+  }
+  return (float)(count - 1);
+}
+
+float _osc_bl_saw_idx(float note)
+{
+  return bl_idx(wt_saw_notes, k_wt_saw_notes_cnt, note);
+}
+
+float _osc_bl_sqr_idx(float note)
+{
+  return bl_idx(wt_sqr_notes, k_wt_sqr_notes_cnt, note);
+}
+
+uint32_t _osc_rand(void)
+{
+  // xorshift32
+  uint32_t x = s_rand_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return s_rand_state = x;
+}
+
+float _osc_white(void)
+{
+  return (float)(int32_t)_osc_rand() * 4.65661287307739e-010f;
+}
@@ -0,0 +1,342 @@
+/*
+ * File: render.cpp
+ *
+ * Offline renderer: drives a unit's hooks from a text script and writes the
+ * result to a WAV file.
+ *
+ * Script format, one event per line ('#' starts a comment):
+ *
+ *   <time ms> <command> [args...]
+ *
+ * Oscillator commands:
+ *   noteon <note> [fine]    set pitch and call OSC_NOTEON
+ *   noteoff                 call OSC_NOTEOFF
+ *   pitch <note> [fine]     change pitch without retriggering
+ *   param <id> <value>      OSC_PARAM, id is id1-id6, shape or shiftshape,
+ *                           value is the raw 16 bit value
+ *   lfo <value>             shape LFO value in [-1, 1]
+ *   lfo sine <hz> [depth]   running shape LFO, sampled once per block as
+ *                           on the hardware (depth defaults to 1)
+ *
+ * Modulation effect commands:
+ *   param <time|depth> <value>          MODFX_PARAM, value in [0, 1]
+ *   input <sine|saw|noise|off> [hz] [amp] test signal fed to main and sub
+ *   bpm <value>                         tempo reported by fx_get_bpmf()
+ *
+ * Common commands:
+ *   end                     stop rendering at this time
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <vector>
+
+#include "units.h"
+#include "fx_api.h"
+#include "wav.h"
+
+#define k_max_block (64)
+
+typedef struct Event {
+  uint32_t frame;
+  char cmd[16];
+  char arg[16];
+  float val0;
+  float val1;
+  int nvals;
+} Event;
+
+typedef struct Lfo {
+  bool running;
+  float w0;     // cycles per frame
+  float depth;
+  float phase;
+} Lfo;
+
+typedef struct Input {
+  uint8_t type; // 0: off, 1: sine, 2: saw, 3: noise
+  float w0;
+  float amp;
+  float phase;
+} Input;
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: nts1-render [-b frames] <unit> <script> <out.wav>\n"
+          "       nts1-render -l\n"
+          "  -b frames  block size passed to the cycle/process hook (1-%d, default %d)\n"
+          "  -l         list units\n",
+          k_max_block, k_max_block);
+}
+
+static bool load_script(const char *path, std::vector<Event> &events)
+{
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "error: cannot open %s\n", path);
+    return false;
+  }
+  char line[256];
+  uint32_t lineno = 0;
+  uint32_t last = 0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    lineno++;
+    char *comment = strchr(line, '#');
+    if (comment != NULL)
+      *comment = '\0';
+    Event ev;
+    memset(&ev, 0, sizeof(ev));
+    const char *tok = strtok(line, " \t\r\n");
+    if (tok == NULL)
+      continue;
+    const float ms = strtof(tok, NULL);
+    tok = strtok(NULL, " \t\r\n");
+    if (tok == NULL || ms < 0.f) {
+      fprintf(stderr, "error: %s:%u: malformed event\n", path, lineno);
+      fclose(fp);
+      return false;
+    }
+    strncpy(ev.cmd, tok, sizeof(ev.cmd) - 1);
+    ev.frame = (uint32_t)(ms * 0.001f * k_samplerate + 0.5f);
+    if (ev.frame < last) {
+      fprintf(stderr, "error: %s:%u: events must be in time order\n", path, lineno);
+      fclose(fp);
+      return false;
+    }
+    last = ev.frame;
+    // A leading non numeric argument is a name (parameter id, input type).
+    while ((tok = strtok(NULL, " \t\r\n")) != NULL) {
+      char *end;
+      const float v = strtof(tok, &end);
+      if (*end != '\0') {
+        if (ev.arg[0] != '\0' || ev.nvals > 0)
+          break;
+        strncpy(ev.arg, tok, sizeof(ev.arg) - 1);
+      } else if (ev.nvals == 0) {
+        ev.val0 = v;
+        ev.nvals++;
+      } else if (ev.nvals == 1) {
+        ev.val1 = v;
+        ev.nvals++;
+      }
+    }
+    events.push_back(ev);
+  }
+  fclose(fp);
+  return true;
+}
+
+static int osc_param_index(const Event &ev)
+{
+  static const char * const names[k_num_user_osc_param_id] = {
+    "id1", "id2", "id3", "id4", "id5", "id6", "shape", "shiftshape"
+  };
+  for (int i = 0; i < k_num_user_osc_param_id; i++) {
+    if (strcmp(ev.arg, names[i]) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static bool apply_osc_event(const host_unit_t *unit, const Event &ev, user_osc_param_t &params, Lfo &lfo)
+{
+  if (strcmp(ev.cmd, "noteon") == 0 || strcmp(ev.cmd, "pitch") == 0) {
+    const uint16_t note = (uint16_t)clipminmaxf(0.f, ev.val0, 151.f);
+    const uint16_t fine = (ev.nvals > 1) ? (uint16_t)clipminmaxf(0.f, ev.val1, 255.f) : 0;
+    params.pitch = (note << 8) | fine;
+    if (ev.cmd[0] == 'n')
+      unit->osc.func_on(&params);
+  } else if (strcmp(ev.cmd, "noteoff") == 0) {
+    unit->osc.func_off(&params);
+  } else if (strcmp(ev.cmd, "param") == 0) {
+    const int idx = osc_param_index(ev);
+    if (idx < 0 || ev.nvals < 1)
+      return false;
+    unit->osc.func_param((uint16_t)idx, (uint16_t)ev.val0);
+  } else if (strcmp(ev.cmd, "lfo") == 0) {
+    if (strcmp(ev.arg, "sine") == 0 && ev.nvals > 0) {
+      lfo.running = true;
+      lfo.w0 = ev.val0 * k_samplerate_recipf;
+      lfo.depth = (ev.nvals > 1) ? ev.val1 : 1.f;
+    } else if (ev.arg[0] == '\0' && ev.nvals > 0) {
+      lfo.running = false;
+      params.shape_lfo = f32_to_q31(clip1m1f(ev.val0));
+    } else {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool apply_modfx_event(const host_unit_t *unit, const Event &ev, Input &input)
+{
+  if (strcmp(ev.cmd, "param") == 0) {
+    uint8_t idx;
+    if (strcmp(ev.arg, "time") == 0)
+      idx = k_user_modfx_param_time;
+    else if (strcmp(ev.arg, "depth") == 0)
+      idx = k_user_modfx_param_depth;
+    else
+      return false;
+    unit->modfx.func_param(idx, f32_to_q31(clip01f(ev.val0)));
+  } else if (strcmp(ev.cmd, "input") == 0) {
+    if (strcmp(ev.arg, "off") == 0)
+      input.type = 0;
+    else if (strcmp(ev.arg, "sine") == 0)
+      input.type = 1;
+    else if (strcmp(ev.arg, "saw") == 0)
+      input.type = 2;
+    else if (strcmp(ev.arg, "noise") == 0)
+      input.type = 3;
+    else
+      return false;
+    input.w0 = ((ev.nvals > 0) ? ev.val0 : 110.f) * k_samplerate_recipf;
+    input.amp = (ev.nvals > 1) ? ev.val1 : 0.5f;
+  } else if (strcmp(ev.cmd, "bpm") == 0) {
+    fx_host_set_bpmf(ev.val0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static void render_input(Input &input, float *xn, uint32_t frames)
+{
+  for (uint32_t i = 0; i < frames; i++) {
+    float sig;
+    switch (input.type) {
+    case 1:
+      sig = sinf(2.f * (float)M_PI * input.phase);
+      break;
+    case 2:
+      sig = 2.f * input.phase - 1.f;
+      break;
+    case 3:
+      sig = fx_white();
+      break;
+    default:
+      sig = 0.f;
+      break;
+    }
+    xn[2*i] = xn[2*i+1] = input.amp * sig;
+    input.phase += input.w0;
+    input.phase -= (uint32_t)input.phase;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t block = k_max_block;
+  int argi = 1;
+  for (; argi < argc && argv[argi][0] == '-'; argi++) {
+    if (strcmp(argv[argi], "-l") == 0) {
+      for (uint32_t i = 0; i < host_units_count; i++)
+        printf("%s\n", host_units[i].name);
+      return 0;
+    } else if (strcmp(argv[argi], "-b") == 0 && argi + 1 < argc) {
+      block = (uint32_t)atoi(argv[++argi]);
+      if (block < 1 || block > k_max_block) {
+        usage();
+        return 1;
+      }
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (argc - argi != 3) {
+    usage();
+    return 1;
+  }
+
+  const host_unit_t *unit = host_unit_find(argv[argi]);
+  if (unit == NULL) {
+    fprintf(stderr, "error: unknown unit %s\n", argv[argi]);
+    return 1;
+  }
+
+  std::vector<Event> events;
+  if (!load_script(argv[argi + 1], events))
+    return 1;
+
+  uint32_t total = 0;
+  for (size_t i = 0; i < events.size(); i++) {
+    if (strcmp(events[i].cmd, "end") == 0) {
+      total = events[i].frame;
+      break;
+    }
+  }
+  if (total == 0) {
+    fprintf(stderr, "error: script has no end event\n");
+    return 1;
+  }
+
+  const bool is_osc = (unit->module == k_user_module_osc);
+  const uint16_t channels = is_osc ? 1 : 2;
+  std::vector<float> out((size_t)total * channels);
+
+  const uint32_t platform = k_user_target_nutektdigital;
+  user_osc_param_t params;
+  memset(&params, 0, sizeof(params));
+  Lfo lfo;
+  memset(&lfo, 0, sizeof(lfo));
+  Input input;
+  memset(&input, 0, sizeof(input));
+
+  if (is_osc)
+    unit->osc.func_init(platform, USER_API_VERSION);
+  else
+    unit->modfx.func_init(platform, USER_API_VERSION);
+
+  size_t next = 0;
+  uint32_t pos = 0;
+  while (pos < total) {
+    for (; next < events.size() && events[next].frame <= pos; next++) {
+      const Event &ev = events[next];
+      if (strcmp(ev.cmd, "end") == 0)
+        continue;
+      const bool ok = is_osc ? apply_osc_event(unit, ev, params, lfo) : apply_modfx_event(unit, ev, input);
+      if (!ok) {
+        fprintf(stderr, "error: bad event '%s %s' at frame %u\n", ev.cmd, ev.arg, ev.frame);
+        return 1;
+      }
+    }
+
+    // Split blocks at event boundaries so that events are sample accurate.
+    uint32_t frames = clipmaxu32(block, total - pos);
+    if (next < events.size())
+      frames = clipmaxu32(frames, events[next].frame - pos);
+
+    if (is_osc) {
+      int32_t yn[k_max_block];
+      if (lfo.running) {
+        params.shape_lfo = f32_to_q31(clip1m1f(lfo.depth * sinf(2.f * (float)M_PI * lfo.phase)));
+        lfo.phase += lfo.w0 * frames;
+        lfo.phase -= (uint32_t)lfo.phase;
+      }
+      unit->osc.func_cycle(&params, yn, frames);
+      for (uint32_t i = 0; i < frames; i++)
+        out[pos + i] = q31_to_f32(yn[i]);
+    } else {
+      float main_xn[2 * k_max_block], sub_xn[2 * k_max_block];
+      float sub_yn[2 * k_max_block];
+      render_input(input, main_xn, frames);
+      memcpy(sub_xn, main_xn, sizeof(float) * 2 * frames);
+      unit->modfx.func_process(main_xn, &out[2 * (size_t)pos], sub_xn, sub_yn, frames);
+    }
+    pos += frames;
+  }
+
+  if (!wav_write_f32(argv[argi + 2], &out[0], total, channels, k_samplerate)) {
+    fprintf(stderr, "error: cannot write %s\n", argv[argi + 2]);
+    return 1;
+  }
+  return 0;
+}
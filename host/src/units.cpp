@@ -0,0 +1,70 @@
+/*
+ * File: units.cpp
+ *
+ * Hook tables for the units linked into the host tools.
+ *
+ */
+
+#include <string.h>
+
+#include "units.h"
+
+// Weak defaults mirror the ones in tpl/_unit.c so that units only need to
+// define the hooks they actually use.
+#define HOST_OSC_HOOKS(p)                                                           \
+  extern "C" {                                                                      \
+    __attribute__((weak)) void p##_hook_init(uint32_t, uint32_t) {}                 \
+    __attribute__((weak)) void p##_hook_cycle(const user_osc_param_t * const,       \
+                                              int32_t *, const uint32_t) {}         \
+    __attribute__((weak)) void p##_hook_on(const user_osc_param_t * const) {}       \
+    __attribute__((weak)) void p##_hook_off(const user_osc_param_t * const) {}      \
+    __attribute__((weak)) void p##_hook_mute(const user_osc_param_t * const) {}     \
+    __attribute__((weak)) void p##_hook_value(uint16_t) {}                          \
+    __attribute__((weak)) void p##_hook_param(uint16_t, uint16_t) {}                \
+  }
+
+#define HOST_MODFX_HOOKS(p)                                                         \
+  extern "C" {                                                                      \
+    __attribute__((weak)) void p##_hook_init(uint32_t, uint32_t) {}                 \
+    __attribute__((weak)) void p##_hook_process(const float *, float *,             \
+                                                const float *, float *,             \
+                                                uint32_t) {}                        \
+    __attribute__((weak)) void p##_hook_suspend(void) {}                            \
+    __attribute__((weak)) void p##_hook_resume(void) {}                             \
+    __attribute__((weak)) void p##_hook_param(uint8_t, int32_t) {}                  \
+  }
+
+#define HOST_OSC_UNIT(n, p)                                                         \
+  { n, k_user_module_osc,                                                           \
+    { p##_hook_init, p##_hook_cycle, p##_hook_on, p##_hook_off,                     \
+      p##_hook_mute, p##_hook_value, p##_hook_param },                              \
+    { 0, 0, 0, 0, 0 } }
+
+#define HOST_MODFX_UNIT(n, p)                                                       \
+  { n, k_user_module_modfx,                                                         \
+    { 0, 0, 0, 0, 0, 0, 0 },                                                        \
+    { p##_hook_init, p##_hook_process, p##_hook_suspend, p##_hook_resume,           \
+      p##_hook_param } }
+
+HOST_OSC_HOOKS(chords_osc)
+HOST_OSC_HOOKS(osc_808)
+HOST_OSC_HOOKS(additive_osc)
+HOST_MODFX_HOOKS(distort_mod)
+
+const host_unit_t host_units[] = {
+  HOST_OSC_UNIT("chords-osc", chords_osc),
+  HOST_OSC_UNIT("osc-808", osc_808),
+  HOST_OSC_UNIT("additive-osc", additive_osc),
+  HOST_MODFX_UNIT("distort-mod", distort_mod),
+};
+
+const uint32_t host_units_count = sizeof(host_units) / sizeof(host_units[0]);
+
+const host_unit_t *host_unit_find(const char *name)
+{
+  for (uint32_t i = 0; i < host_units_count; i++) {
+    if (strcmp(host_units[i].name, name) == 0)
+      return &host_units[i];
+  }
+  return NULL;
+}
@@ -0,0 +1,66 @@
+/*
+ * File: units.h
+ *
+ * Registry of the units linked into the host tools.
+ *
+ * Every unit is compiled with its _hook_* entry points renamed to
+ * <prefix>_hook_* (see HOOK_DEFS in host/Makefile) so that all of them can be
+ * linked into a single binary. The tables below play the role of the
+ * s_hook_table emitted by tpl/_unit.c on the target.
+ *
+ */
+
+#ifndef __units_h
+#define __units_h
+
+#include <stdint.h>
+
+#define USER_HOST_REGISTRY
+
+#include "userosc.h"
+#include "usermodfx.h"
+
+typedef void (*osc_init_fptr)(uint32_t platform, uint32_t api);
+typedef void (*osc_cycle_fptr)(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames);
+typedef void (*osc_note_fptr)(const user_osc_param_t * const params);
+typedef void (*osc_value_fptr)(uint16_t value);
+typedef void (*osc_param_fptr)(uint16_t index, uint16_t value);
+
+typedef void (*modfx_init_fptr)(uint32_t platform, uint32_t api);
+typedef void (*modfx_process_fptr)(const float *main_xn, float *main_yn,
+                                   const float *sub_xn,  float *sub_yn,
+                                   uint32_t frames);
+typedef void (*modfx_void_fptr)(void);
+typedef void (*modfx_param_fptr)(uint8_t index, int32_t value);
+
+typedef struct user_osc_hooks {
+  osc_init_fptr  func_init;
+  osc_cycle_fptr func_cycle;
+  osc_note_fptr  func_on;
+  osc_note_fptr  func_off;
+  osc_note_fptr  func_mute;
+  osc_value_fptr func_value;
+  osc_param_fptr func_param;
+} user_osc_hooks_t;
+
+typedef struct user_modfx_hooks {
+  modfx_init_fptr    func_init;
+  modfx_process_fptr func_process;
+  modfx_void_fptr    func_suspend;
+  modfx_void_fptr    func_resume;
+  modfx_param_fptr   func_param;
+} user_modfx_hooks_t;
+
+typedef struct host_unit {
+  const char *name;
+  uint8_t module; // k_user_module_osc or k_user_module_modfx
+  user_osc_hooks_t osc;
+  user_modfx_hooks_t modfx;
+} host_unit_t;
+
+extern const host_unit_t host_units[];
+extern const uint32_t host_units_count;
+
+const host_unit_t *host_unit_find(const char *name);
+
+#endif // __units_h
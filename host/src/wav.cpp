@@ -0,0 +1,58 @@
+/*
+ * File: wav.cpp
+ *
+ * Minimal IEEE float WAV writer for the host tools.
+ *
+ */
+
+#include <stdio.h>
+
+#include "wav.h"
+
+static void put_u16(FILE *fp, uint16_t v)
+{
+  const uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+  fwrite(b, 1, 2, fp);
+}
+
+static void put_u32(FILE *fp, uint32_t v)
+{
+  const uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+  fwrite(b, 1, 4, fp);
+}
+
+bool wav_write_f32(const char *path, const float *data, uint32_t frames,
+                   uint16_t channels, uint32_t samplerate)
+{
+  FILE *fp = fopen(path, "wb");
+  if (fp == NULL)
+    return false;
+
+  const uint32_t data_size = frames * channels * 4;
+
+  fwrite("RIFF", 1, 4, fp);
+  put_u32(fp, 4 + (8 + 18) + (8 + 4) + (8 + data_size));
+  fwrite("WAVE", 1, 4, fp);
+
+  fwrite("fmt ", 1, 4, fp);
+  put_u32(fp, 18);
+  put_u16(fp, 3); // WAVE_FORMAT_IEEE_FLOAT
+  put_u16(fp, channels);
+  put_u32(fp, samplerate);
+  put_u32(fp, samplerate * channels * 4);
+  put_u16(fp, channels * 4);
+  put_u16(fp, 32);
+  put_u16(fp, 0);
+
+  fwrite("fact", 1, 4, fp);
+  put_u32(fp, 4);
+  put_u32(fp, frames);
+
+  fwrite("data", 1, 4, fp);
+  put_u32(fp, data_size);
+  // Host is little endian like the WAV format.
+  fwrite(data, 4, (size_t)frames * channels, fp);
+
+  const bool ok = (ferror(fp) == 0);
+  return (fclose(fp) == 0) && ok;
+}
@@ -0,0 +1,19 @@
+/*
+ * File: wav.h
+ *
+ * Minimal IEEE float WAV writer for the host tools.
+ *
+ */
+
+#ifndef __wav_h
+#define __wav_h
+
+#include <stdint.h>
+
+/** Write interleaved float samples as a 32-bit float WAV file.
+ * @return true on success.
+ */
+bool wav_write_f32(const char *path, const float *data, uint32_t frames,
+                   uint16_t channels, uint32_t samplerate);
+
+#endif // __wav_h
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+#
+# File: abcmp.py
+#
+# A/B comparison of a compile-time variant of the units against the
+# default build.
+#
+# The host tools are built twice, into build/ab/ref with the default flags
+# (or the flags given with -r) and into build/ab/var with the given
+# HOST_OPT, then every script in
+# host/scripts (or the ones passed with -s) is rendered with both and the
+# outputs are compared sample by sample. The unit a script drives is read
+# from its first line ("# <unit>: ..."). With -b the benchmark is run on
+# both builds for the units involved and the ns/frame of each case is
+# reported side by side.
+#
+# The exit status is 1 if any render differs by more than the tolerance.
+# A single flag has to follow "--" so that it is not taken for an option.
+#
+# Usage:
+#   abcmp.py [-s script]... [-r ref_opt] [-t tol] [-b] [-o out.json] "<HOST_OPT>"
+#
+# Example:
+#   abcmp.py -b "-DCHORDS_PHASE_Q32=1 -DOSC808_PHASE_Q32=1"
+#   abcmp.py -s host/scripts/chords.txt -- -DCHORDS_VOICE_SIMD=0
+#   abcmp.py -b -r=-DCHORDS_VOICE_SIMD=0 "-DCHORDS_VOICE_SIMD=0 -DCHORDS_VOICE_MAJOR=1"
+#
+
+import argparse
+import json
+import math
+import os
+import struct
+import subprocess
+import sys
+
+k_hostdir = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+
+
+def read_wav_f32(path):
+    with open(path, 'rb') as fp:
+        d = fp.read()
+    if d[:4] != b'RIFF' or d[8:12] != b'WAVE':
+        raise ValueError('%s: not a WAV file' % path)
+    i = d.index(b'data')
+    n = struct.unpack('<I', d[i + 4:i + 8])[0] // 4
+    return struct.unpack('<%df' % n, d[i + 8:i + 8 + n * 4])
+
+
+def compare(ref, var):
+    n = min(len(ref), len(var))
+    max_abs = 0.0
+    err = 0.0
+    sig = 0.0
+    for a, b in zip(ref[:n], var[:n]):
+        e = abs(a - b)
+        if e > max_abs:
+            max_abs = e
+        err += e * e
+        sig += a * a
+    rms_diff = math.sqrt(err / n) if n else 0.0
+    if err == 0.0:
+        snr_db = float('inf')
+    elif sig == 0.0:
+        snr_db = float('-inf')
+    else:
+        snr_db = 10.0 * math.log10(sig / err)
+    return {'samples': n, 'length_match': len(ref) == len(var),
+            'max_abs_diff': max_abs, 'rms_diff': rms_diff, 'snr_db': snr_db}
+
+
+def script_unit(path):
+    with open(path) as fp:
+        line = fp.readline()
+    if not line.startswith('#') or ':' not in line:
+        raise ValueError('%s: first line does not name the unit' % path)
+    return line[1:].split(':')[0].strip()
+
+
+def build(builddir, host_opt):
+    # -B as the objects do not depend on HOST_OPT
+    cmd = ['make', '-s', '-B', '-C', k_hostdir, 'BUILDDIR=' + builddir, 'HOST_OPT=' + host_opt]
+    subprocess.check_call(cmd, stdout=subprocess.DEVNULL)
+    return os.path.join(k_hostdir, builddir)
+
+
+def bench(builddir, unit):
+    out = subprocess.check_output([os.path.join(builddir, 'nts1-bench'), '-u', unit],
+                                  stderr=subprocess.DEVNULL)
+    return json.loads(out)['results']
+
+
+def main():
+    ap = argparse.ArgumentParser(description='compare a HOST_OPT variant against the default build')
+    ap.add_argument('host_opt', help='compiler flags of the variant, e.g. "-DCHORDS_PHASE_Q32=1"')
+    ap.add_argument('-s', dest='scripts', action='append', help='render script (default: host/scripts/*.txt)')
+    ap.add_argument('-r', dest='ref_opt', default='', help='compiler flags of the reference (default: none)')
+    ap.add_argument('-t', dest='tol', type=float, default=1e-4, help='max abs difference allowed (default 1e-4)')
+    ap.add_argument('-b', dest='bench', action='store_true', help='benchmark both builds')
+    ap.add_argument('-o', dest='out', help='write JSON results to this file')
+    args = ap.parse_args()
+
+    scripts = args.scripts
+    if not scripts:
+        sdir = os.path.join(k_hostdir, 'scripts')
+        scripts = [os.path.join(sdir, f) for f in sorted(os.listdir(sdir)) if f.endswith('.txt')]
+
+    ref_dir = build('build/ab/ref', args.ref_opt)
+    var_dir = build('build/ab/var', args.host_opt)
+
+    result = {'ref_opt': args.ref_opt, 'host_opt': args.host_opt, 'tolerance': args.tol, 'renders': [], 'bench': []}
+    failed = False
+    units = []
+    for s in scripts:
+        unit = script_unit(s)
+        if unit not in units:
+            units.append(unit)
+        name = os.path.splitext(os.path.basename(s))[0]
+        wavs = []
+        for d in (ref_dir, var_dir):
+            wav = os.path.join(d, name + '.wav')
+            subprocess.check_call([os.path.join(d, 'nts1-render'), unit, s, wav], stderr=subprocess.DEVNULL)
+            wavs.append(read_wav_f32(wav))
+        c = compare(wavs[0], wavs[1])
+        c['script'] = name
+        c['unit'] = unit
+        c['pass'] = c['length_match'] and c['max_abs_diff'] <= args.tol
+        failed = failed or not c['pass']
+        result['renders'].append(c)
+        sys.stderr.write('%-12s %-10s max %.3g  rms %.3g  snr %6.1f dB  %s\n'
+                         % (unit, name, c['max_abs_diff'], c['rms_diff'], c['snr_db'],
+                            'ok' if c['pass'] else 'FAIL'))
+
+    if args.bench:
+        for unit in units:
+            ref = bench(ref_dir, unit)
+            var = bench(var_dir, unit)
+            for r, v in zip(ref, var):
+                ratio = v['ns_per_frame'] / r['ns_per_frame']
+                result['bench'].append({'unit': unit, 'case': r['case'], 'frames': r['frames'],
+                                        'ref_ns_per_frame': r['ns_per_frame'],
+                                        'var_ns_per_frame': v['ns_per_frame'],
+                                        'ratio': ratio})
+                sys.stderr.write('%-12s %-60s %3d frames  %8.3f -> %8.3f ns/frame  x%.2f\n'
+                                 % (unit, json.dumps(r['case'])[1:-1], r['frames'],
+                                    r['ns_per_frame'], v['ns_per_frame'], ratio))
+
+    text = json.dumps(result, indent=2).replace('Infinity', '"inf"')
+    if args.out:
+        with open(args.out, 'w') as fp:
+            fp.write(text + '\n')
+    else:
+        print(text)
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,511 @@
+#!/usr/bin/env python3
+#
+# File: m4prof.py
+#
+# Cortex-M4 cost profiler for the unit ELFs in <unit>/build.
+#
+# The ELF is loaded at its link address (0x20000000 for oscillators per
+# userosc.ld, 0x20017800 for modulation effects per usermodfx.ld) into a
+# Unicorn engine (the QEMU ARM core packaged as a library), the runtime
+# tables exported by osc_api.syms/main_api.syms are filled in with host
+# generated data and the runtime functions are replaced by stubs. The hooks
+# found in the .hooks table are then called directly: _entry (BSS clear and
+# OSC_INIT/MODFX_INIT), func_param for each requested parameter, func_on,
+# and func_cycle/func_process for a number of blocks.
+#
+# Instructions are counted exactly. Cycles are estimated from the Cortex-M4
+# TRM timings: one cycle per instruction, plus one per memory read, plus two
+# for every taken branch (pipeline refill), plus the extra cycles of
+# VDIV/VSQRT (14), VMLA/VFMA families (3) and SDIV/UDIV (~7 average). Flash
+# wait states and bus contention are not modelled.
+#
+# The M4 runs at 168 MHz, which leaves 3500 cycles per 48 kHz sample.
+#
+# Experimental: only --info has been run so far. The emulation and the
+# cycle estimate have not been checked against a unit running on the
+# NTS-1, so treat the figures as unverified. The system control space is
+# not mapped, a unit built with a chords-osc CHORDS_BUDGET reads the DWT
+# cycle counter and faults here.
+#
+# Requirements: python3 with the unicorn package (pip install unicorn).
+#
+# Usage:
+#   m4prof.py --info <elf>
+#   m4prof.py [-p name=value]... [-f frames[,frames...]] [-n calls] [-o out.json] <elf>
+#
+# Oscillator parameters: id1..id6, shape, shiftshape (raw values as passed
+# to OSC_PARAM), note (MIDI note, default 48), lfo (shape LFO in [-1, 1]).
+# Modulation effect parameters: time, depth (in [0, 1]), bpm, input_hz,
+# input_amp (saw fed to main and sub).
+#
+
+import argparse
+import json
+import math
+import os
+import struct
+import sys
+
+k_samplerate = 48000
+k_core_hz = 168000000
+k_budget_cycles = k_core_hz // k_samplerate
+
+k_osc_params = ['id1', 'id2', 'id3', 'id4', 'id5', 'id6', 'shape', 'shiftshape']
+
+# Hook table offsets, see tpl/_unit.c
+k_hook_entry = 16
+k_osc_hooks = {'cycle': 20, 'on': 24, 'off': 28, 'mute': 32, 'value': 36, 'param': 40}
+k_modfx_hooks = {'process': 20, 'suspend': 24, 'resume': 28, 'param': 32}
+
+k_platform_nutektdigital = 3 << 8
+k_api_version = (1 << 16) | (1 << 8)
+
+# Scratch memory for the stack, arguments and buffers, away from the unit.
+k_scratch_base = 0x30000000
+k_scratch_size = 0x10000
+k_stack_top = k_scratch_base + 0x8000
+k_params_addr = k_scratch_base + 0x8000
+k_buf_addr = k_scratch_base + 0x9000
+k_return_addr = 0x3f000000
+
+k_api_base = 0x08000000
+k_api_size = 0x00080000
+
+
+# ----------------------------------------------------------------------------
+# ELF
+# ----------------------------------------------------------------------------
+
+class Elf:
+    def __init__(self, path):
+        with open(path, 'rb') as fp:
+            self.data = fp.read()
+        d = self.data
+        if d[:4] != b'\x7fELF' or d[4] != 1 or d[5] != 1:
+            raise ValueError('%s: not a 32-bit little endian ELF' % path)
+        (self.e_type, self.e_machine, _, self.e_entry, self.e_phoff, self.e_shoff,
+         _, _, self.e_phentsize, self.e_phnum, self.e_shentsize, self.e_shnum,
+         self.e_shstrndx) = struct.unpack_from('<HHIIIIIHHHHHH', d, 16)
+        if self.e_machine != 40:
+            raise ValueError('%s: not an ARM ELF' % path)
+        self.sections = {}
+        shstr = self._section_header(self.e_shstrndx)
+        for i in range(self.e_shnum):
+            sh = self._section_header(i)
+            name = self._cstr(shstr['offset'] + sh['name'])
+            self.sections[name] = sh
+
+    def _section_header(self, i):
+        (name, stype, flags, addr, offset, size, link, info, align, entsize) = \
+            struct.unpack_from('<IIIIIIIIII', self.data, self.e_shoff + i * self.e_shentsize)
+        return {'name': name, 'type': stype, 'flags': flags, 'addr': addr,
+                'offset': offset, 'size': size}
+
+    def _cstr(self, off):
+        end = self.data.index(b'\0', off)
+        return self.data[off:end].decode('ascii')
+
+    def segments(self):
+        """Yield (vaddr, file bytes, memsz) for every PT_LOAD segment."""
+        for i in range(self.e_phnum):
+            (ptype, offset, vaddr, _, filesz, memsz, _, _) = \
+                struct.unpack_from('<IIIIIIII', self.data, self.e_phoff + i * self.e_phentsize)
+            if ptype == 1:
+                yield vaddr, self.data[offset:offset + filesz], memsz
+
+    def read(self, addr, size):
+        for sh in self.sections.values():
+            if sh['type'] != 8 and sh['addr'] <= addr and addr + size <= sh['addr'] + sh['size']:
+                off = sh['offset'] + addr - sh['addr']
+                return self.data[off:off + size]
+        raise ValueError('address 0x%08x not in a loaded section' % addr)
+
+
+def read_hook_table(elf):
+    hooks = elf.sections.get('.hooks')
+    if hooks is None:
+        raise ValueError('no .hooks section')
+    raw = elf.read(hooks['addr'], 0x40)
+    magic = raw[0:4].decode('ascii', 'replace')
+    api, = struct.unpack_from('<I', raw, 4)
+    table = {'addr': hooks['addr'], 'magic': magic, 'api': api, 'platform': raw[8],
+             'entry': struct.unpack_from('<I', raw, k_hook_entry)[0]}
+    if magic == 'UOSC':
+        table['module'] = 'osc'
+        offsets = k_osc_hooks
+    elif magic == 'UMOD':
+        table['module'] = 'modfx'
+        offsets = k_modfx_hooks
+    else:
+        raise ValueError('unknown hook table magic %r' % magic)
+    for name, off in offsets.items():
+        table[name] = struct.unpack_from('<I', raw, off)[0]
+    return table
+
+
+def read_syms(path):
+    syms = {}
+    with open(path) as fp:
+        for line in fp:
+            line = line.strip().rstrip(';')
+            if '=' in line:
+                name, value = line.split('=')
+                syms[name.strip()] = int(value.strip(), 0)
+    return syms
+
+
+# ----------------------------------------------------------------------------
+# Runtime tables, identical to host/src/luts.cpp
+# ----------------------------------------------------------------------------
+
+k_wt_size = 128
+k_wt_notes = [40, 52, 64, 76, 88, 100, 112]
+
+
+def note_hz(note):
+    return 440.0 * 2.0 ** ((note - 69.0) / 12.0)
+
+
+def bl_table(note, odd_only):
+    harmonics = min(int(24000.0 / note_hz(note)), k_wt_size - 1)
+    out = []
+    for i in range(k_wt_size + 1):
+        p = i / (2.0 * k_wt_size)
+        acc = sum(math.sin(2.0 * math.pi * k * p) / k
+                  for k in range(1, harmonics + 1, 2 if odd_only else 1))
+        out.append((4.0 / math.pi) * acc if odd_only else -(2.0 / math.pi) * acc)
+    return out
+
+
+def runtime_tables():
+    f32 = lambda values: struct.pack('<%df' % len(values), *values)
+    tables = {
+        'midi_to_hz_lut_f': f32([note_hz(i) for i in range(152)]),
+        'wt_sine_lut_f': f32([math.sin(math.pi * i / k_wt_size) for i in range(k_wt_size + 1)]),
+        'wt_saw_notes': bytes(k_wt_notes),
+        'wt_sqr_notes': bytes(k_wt_notes),
+        'k_osc_api_version': struct.pack('<I', k_api_version),
+        'k_fx_api_version': struct.pack('<I', k_api_version),
+        'k_osc_api_platform': struct.pack('<I', k_platform_nutektdigital),
+        'k_fx_api_platform': struct.pack('<I', k_platform_nutektdigital),
+    }
+    tables['wt_saw_lut_f'] = b''.join(f32(bl_table(n, False)) for n in k_wt_notes)
+    tables['wt_sqr_lut_f'] = b''.join(f32(bl_table(n, True)) for n in k_wt_notes)
+    # Other tables (tanpi, log, schetzen, waves*...) are left zeroed: the
+    # units in this repository do not read them.
+    return tables
+
+
+# ----------------------------------------------------------------------------
+# Emulation
+# ----------------------------------------------------------------------------
+
+class Profiler:
+    def __init__(self, elf_path, syms_path, bpm):
+        import unicorn
+        from unicorn import arm_const
+        self.uc_mod = unicorn
+        self.arm = arm_const
+
+        self.elf = Elf(elf_path)
+        self.table = read_hook_table(self.elf)
+        self.syms = read_syms(syms_path)
+        self.bpm = bpm
+        self.rand_state = 0x12345678
+
+        uc = self.uc = unicorn.Uc(unicorn.UC_ARCH_ARM, unicorn.UC_MODE_THUMB)
+        a = arm_const
+
+        # Unit image(s). Modfx units may also place data in SDRAM.
+        mapped = []
+        for vaddr, data, memsz in self.elf.segments():
+            base = vaddr & ~0xFFF
+            size = ((vaddr + memsz + 0xFFF) & ~0xFFF) - base
+            if not any(b <= base < b + s for b, s in mapped):
+                uc.mem_map(base, size)
+                mapped.append((base, size))
+            uc.mem_write(vaddr, data)
+        if self.table['module'] == 'modfx':
+            uc.mem_map(0xC0400000, 0x20000)
+
+        uc.mem_map(k_scratch_base, k_scratch_size)
+        uc.mem_map(k_return_addr & ~0xFFF, 0x1000)
+        uc.mem_write(k_return_addr, b'\x70\x47')  # bx lr, never reached
+
+        # Runtime API: tables and stubbed functions.
+        uc.mem_map(k_api_base, k_api_size)
+        for name, blob in runtime_tables().items():
+            if name in self.syms:
+                uc.mem_write(self.syms[name], blob)
+        self.stubs = {}
+        for name, handler in (('_osc_bl_saw_idx', self._stub_bl_idx),
+                              ('_osc_bl_sqr_idx', self._stub_bl_idx),
+                              ('_osc_bl_par_idx', self._stub_bl_idx),
+                              ('_osc_rand', self._stub_rand),
+                              ('_fx_rand', self._stub_rand),
+                              ('_osc_white', self._stub_white),
+                              ('_fx_white', self._stub_white),
+                              ('_osc_mcu_hash', self._stub_zero),
+                              ('_fx_mcu_hash', self._stub_zero),
+                              ('_fx_get_bpm', self._stub_bpm),
+                              ('_fx_get_bpmf', self._stub_bpmf)):
+            if name in self.syms:
+                addr = self.syms[name] & ~1
+                uc.mem_write(addr, b'\x70\x47')  # bx lr
+                self.stubs[addr] = handler
+        uc.hook_add(unicorn.UC_HOOK_CODE, self._on_stub, begin=k_api_base, end=k_api_base + k_api_size - 1)
+
+        # Enable the VFP: CPACR cp10/cp11 full access and FPEXC.EN.
+        uc.reg_write(a.UC_ARM_REG_C1_C0_2, uc.reg_read(a.UC_ARM_REG_C1_C0_2) | (0xF << 20))
+        uc.reg_write(a.UC_ARM_REG_FPEXC, 0x40000000)
+
+        self.counting = False
+        uc.hook_add(unicorn.UC_HOOK_CODE, self._on_code)
+        uc.hook_add(unicorn.UC_HOOK_MEM_READ, self._on_read)
+        self.reset_counters()
+
+    # Stubs ------------------------------------------------------------------
+
+    def _reg_f32(self, reg):
+        return struct.unpack('<f', struct.pack('<I', self.uc.reg_read(reg) & 0xFFFFFFFF))[0]
+
+    def _set_f32(self, reg, value):
+        self.uc.reg_write(reg, struct.unpack('<I', struct.pack('<f', value))[0])
+
+    def _stub_bl_idx(self):
+        note = self._reg_f32(self.arm.UC_ARM_REG_S0)
+        idx = 0.0
+        if note > k_wt_notes[0]:
+            idx = float(len(k_wt_notes) - 1)
+            for i in range(1, len(k_wt_notes)):
+                if note <= k_wt_notes[i]:
+                    idx = (i - 1) + (note - k_wt_notes[i - 1]) / (k_wt_notes[i] - k_wt_notes[i - 1])
+                    break
+        self._set_f32(self.arm.UC_ARM_REG_S0, idx)
+
+    def _next_rand(self):
+        x = self.rand_state
+        x ^= (x << 13) & 0xFFFFFFFF
+        x ^= x >> 17
+        x ^= (x << 5) & 0xFFFFFFFF
+        self.rand_state = x
+        return x
+
+    def _stub_rand(self):
+        self.uc.reg_write(self.arm.UC_ARM_REG_R0, self._next_rand())
+
+    def _stub_white(self):
+        x = self._next_rand()
+        x = x - (1 << 32) if x & 0x80000000 else x
+        self._set_f32(self.arm.UC_ARM_REG_S0, x / 2147483648.0)
+
+    def _stub_zero(self):
+        self.uc.reg_write(self.arm.UC_ARM_REG_R0, 0)
+
+    def _stub_bpm(self):
+        self.uc.reg_write(self.arm.UC_ARM_REG_R0, int(self.bpm * 10) & 0xFFFF)
+
+    def _stub_bpmf(self):
+        self._set_f32(self.arm.UC_ARM_REG_S0, self.bpm)
+
+    def _on_stub(self, uc, address, size, user_data):
+        handler = self.stubs.get(address)
+        if handler is not None:
+            handler()
+
+    # Counting ---------------------------------------------------------------
+
+    def reset_counters(self):
+        self.insns = 0
+        self.cycles = 0
+        self.prev_end = None
+
+    def _on_code(self, uc, address, size, user_data):
+        if not self.counting:
+            return
+        self.insns += 1
+        cycles = 1
+        if self.prev_end is not None and address != self.prev_end:
+            cycles += 2  # taken branch, pipeline refill
+        self.prev_end = address + size
+        if size == 4:
+            hw0, hw1 = struct.unpack('<HH', uc.mem_read(address, 4))
+            if (hw1 & 0x0E00) == 0x0A00 and (hw0 & 0xEF00) == 0xEE00:
+                opc = ((hw0 >> 4) & 0xB)
+                if opc == 0x8:
+                    cycles += 13  # VDIV
+                elif opc == 0xB and (hw0 & 0xF) == 0x1 and (hw1 & 0x00C0) == 0x00C0:
+                    cycles += 13  # VSQRT
+                elif opc in (0x0, 0x1, 0x9, 0xA):
+                    cycles += 2   # VMLA/VMLS/VNMLA/VNMLS, VFMA/VFMS/VFNMA/VFNMS
+            elif (hw0 & 0xFFD0) == 0xFB90 and (hw1 & 0x00F0) == 0x00F0:
+                cycles += 6  # SDIV/UDIV
+        self.cycles += cycles
+
+    def _on_read(self, uc, access, address, size, value, user_data):
+        if self.counting:
+            self.cycles += 1
+
+    # Calls ------------------------------------------------------------------
+
+    def call(self, func, args=(), stack_args=()):
+        a = self.arm
+        sp = k_stack_top - 4 * len(stack_args)
+        for i, v in enumerate(stack_args):
+            self.uc.mem_write(sp + 4 * i, struct.pack('<I', v & 0xFFFFFFFF))
+        regs = (a.UC_ARM_REG_R0, a.UC_ARM_REG_R1, a.UC_ARM_REG_R2, a.UC_ARM_REG_R3)
+        for reg, v in zip(regs, args):
+            self.uc.reg_write(reg, v & 0xFFFFFFFF)
+        self.uc.reg_write(a.UC_ARM_REG_SP, sp)
+        self.uc.reg_write(a.UC_ARM_REG_LR, k_return_addr | 1)
+        self.reset_counters()
+        self.counting = True
+        try:
+            self.uc.emu_start(func | 1, k_return_addr)
+        finally:
+            self.counting = False
+        return self.insns, self.cycles
+
+
+# ----------------------------------------------------------------------------
+# Main
+# ----------------------------------------------------------------------------
+
+def parse_params(items):
+    params = {}
+    for item in items:
+        if '=' not in item:
+            raise ValueError('bad parameter %r, expected name=value' % item)
+        name, value = item.split('=', 1)
+        params[name.strip()] = float(value)
+    return params
+
+
+def result(unit, case, frames, calls, insns, cycles):
+    per_call_i = insns / calls
+    per_call_c = cycles / calls
+    res = {'unit': unit, 'case': case, 'frames': frames, 'calls': calls,
+           'instructions_per_call': round(per_call_i, 1),
+           'cycles_per_call': round(per_call_c, 1)}
+    if frames:
+        res['instructions_per_frame'] = round(per_call_i / frames, 2)
+        res['cycles_per_frame'] = round(per_call_c / frames, 2)
+        res['budget_pct'] = round(100.0 * per_call_c / frames / k_budget_cycles, 3)
+    return res
+
+
+def profile(args):
+    elf_dir = os.path.dirname(os.path.abspath(args.elf))
+    syms = args.syms
+    if syms is None:
+        for name in ('osc_api.syms', 'main_api.syms'):
+            cand = os.path.join(elf_dir, '..', 'ld', name)
+            if os.path.exists(cand):
+                syms = cand
+                break
+    if syms is None:
+        raise ValueError('cannot find the unit ld/*.syms, use --syms')
+
+    params = parse_params(args.param)
+    prof = Profiler(args.elf, syms, params.get('bpm', 120.0))
+    table = prof.table
+    unit = os.path.splitext(os.path.basename(args.elf))[0]
+    case = {k: v for k, v in sorted(params.items())}
+    results = []
+
+    insns, cycles = prof.call(table['entry'], (k_platform_nutektdigital, k_api_version))
+    results.append(result(unit, {'hook': 'entry'}, 0, 1, insns, cycles))
+
+    if table['module'] == 'osc':
+        for name, value in sorted(params.items()):
+            if name in k_osc_params:
+                insns, cycles = prof.call(table['param'], (k_osc_params.index(name), int(value)))
+                results.append(result(unit, {'hook': 'param', name: value}, 0, 1, insns, cycles))
+        note = int(params.get('note', 48))
+        lfo = max(-1.0, min(1.0, params.get('lfo', 0.0)))
+        # user_osc_param_t: shape_lfo, pitch, cutoff, resonance, reserved0[3]
+        prof.uc.mem_write(k_params_addr, struct.pack('<iHHH3H', int(lfo * 0x7FFFFFFF), note << 8, 0, 0, 0, 0, 0))
+        prof.call(table['on'], (k_params_addr,))
+        for frames in args.frames:
+            insns_t = cycles_t = 0
+            for _ in range(args.calls):
+                insns, cycles = prof.call(table['cycle'], (k_params_addr, k_buf_addr, frames))
+                insns_t += insns
+                cycles_t += cycles
+            results.append(result(unit, dict(case, hook='cycle'), frames, args.calls, insns_t, cycles_t))
+    else:
+        for name, index in (('time', 0), ('depth', 1)):
+            if name in params:
+                q31 = int(max(0.0, min(1.0, params[name])) * 0x7FFFFFFF)
+                insns, cycles = prof.call(table['param'], (index, q31))
+                results.append(result(unit, {'hook': 'param', name: params[name]}, 0, 1, insns, cycles))
+        hz = params.get('input_hz', 110.0)
+        amp = params.get('input_amp', 0.8)
+        max_frames = max(args.frames)
+        main_x = k_buf_addr
+        main_y = main_x + 8 * max_frames
+        sub_x = main_y + 8 * max_frames
+        sub_y = sub_x + 8 * max_frames
+        phase = 0.0
+        for frames in args.frames:
+            insns_t = cycles_t = 0
+            for _ in range(args.calls):
+                samples = []
+                for _ in range(frames):
+                    v = amp * (2.0 * phase - 1.0)
+                    samples += [v, v]
+                    phase = (phase + hz / k_samplerate) % 1.0
+                blob = struct.pack('<%df' % len(samples), *samples)
+                prof.uc.mem_write(main_x, blob)
+                prof.uc.mem_write(sub_x, blob)
+                insns, cycles = prof.call(table['process'], (main_x, main_y, sub_x, sub_y), (frames,))
+                insns_t += insns
+                cycles_t += cycles
+            results.append(result(unit, dict(case, hook='process'), frames, args.calls, insns_t, cycles_t))
+    return results
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Cortex-M4 cost profiler for unit ELFs.')
+    ap.add_argument('elf')
+    ap.add_argument('--info', action='store_true', help='print the hook table and exit')
+    ap.add_argument('--syms', help='runtime symbol file (default: ../ld/*.syms next to the ELF)')
+    ap.add_argument('-p', '--param', action='append', default=[], metavar='NAME=VALUE')
+    ap.add_argument('-f', '--frames', default='64',
+                    type=lambda s: [int(v) for v in s.split(',')],
+                    help='comma separated block sizes (default 64)')
+    ap.add_argument('-n', '--calls', type=int, default=32, help='cycle/process calls per block size')
+    ap.add_argument('-o', '--output', help='write JSON to this file instead of stdout')
+    args = ap.parse_args()
+
+    try:
+        if args.info:
+            table = read_hook_table(Elf(args.elf))
+            for k, v in table.items():
+                print('%-9s %s' % (k, ('0x%08x' % v) if isinstance(v, int) else v))
+            return 0
+        results = profile(args)
+    except ImportError:
+        sys.stderr.write('error: the unicorn python package is required (pip install unicorn)\n')
+        return 1
+    except ValueError as e:
+        sys.stderr.write('error: %s\n' % e)
+        return 1
+
+    out = {'core_hz': k_core_hz, 'samplerate': k_samplerate,
+           'budget_cycles_per_frame': k_budget_cycles, 'results': results}
+    text = json.dumps(out, indent=2)
+    if args.output:
+        with open(args.output, 'w') as fp:
+            fp.write(text + '\n')
+    else:
+        print(text)
+    for r in results:
+        if 'cycles_per_frame' in r:
+            sys.stderr.write('%-12s %3d frames %8.1f insns/frame %8.1f cycles/frame %6.2f%% budget\n' % (
+                r['unit'], r['frames'], r['instructions_per_frame'], r['cycles_per_frame'], r['budget_pct']))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -3,19 +3,55 @@
 //
 
 #include "userosc.h"
+#include "phase_q32.h"
+#include "output_stage.h"
+#include "halfband.h"
+#include "smooth.h"
 //#include "test.h"
 
+// OSC808_PHASE_Q32 selects the phase accumulator at compile time:
+//  0: float phase wrapped with phase -= (uint32_t)phase (default)
+//  1: uint32_t phase scaled by 2^32, see phase_q32.h
+#ifndef OSC808_PHASE_Q32
+#define OSC808_PHASE_Q32 0
+#endif
+
+// OSC808_PD_QUAD selects where the phase distortion modulator comes from:
+//  0: a second sine table lookup per sample
+//  1: a quadrature phasor rotated along with the phase (default)
+#ifndef OSC808_PD_QUAD
+#define OSC808_PD_QUAD 1
+#endif
+
+// OSC808_LFO_RATE is the control rate of the shape LFO in frames: the
+// phase distortion depth is computed this often and ramped in between
+#ifndef OSC808_LFO_RATE
+#define OSC808_LFO_RATE 16
+#endif
+
+#if OSC808_PHASE_Q32
+typedef uint32_t phase_t;
+#else
+typedef float phase_t;
+#endif
+
 typedef struct State {
     float w0; //current delta phase for update
     float w_target;
     float w_init;
     float pitch_decay;
-    float hold_time;
-    float phase;
-    float dist;
-    float drive;
+    float env; //remaining part of the pitch drop, 1 at note on down to 0
+    float env_step; //linear: decrement of env per sample
+    float env_q_ln; //log: ln of the growth of 1 - env per sample
+    uint8_t curve;
+    uint8_t os; //oversampling factor, 1, 2 or 4
+    phase_t phase;
+    Smooth dist; //both follow their parameter over SMOOTH_FRAMES
+    Smooth drive;
     float attack_pitch;
     float lfo, lfoz; //current lfo value (and depth?)
+    float os_hist1[halfband_hist(3)]; //decimator inputs kept between cycles
+    float os_hist2[halfband_hist(5)];
     uint8_t flags;
 };
 
@@ -24,21 +60,248 @@ static State s_state;
 enum {
     k_flags_none = 0,
     k_flag_reset = 1<<0,
+    k_flag_os_reset = 1<<1, //oversampling factor changed
 };
 
+// Pitch envelope curves
+enum {
+    k_curve_lin = 0,
+    k_curve_exp,
+    k_curve_log,
+    k_num_curves,
+};
+
+// The exponential curve covers this many time constants over the decay
+// time, down to 0.7% of the drop
+#define k_env_exp_taus (5.f)
+// The log curve starts 1/1000 of the drop in and reaches the end at the
+// decay time
+#define k_env_log_start (1e-3f)
+#define k_env_log_ln_range (6.9077553f) // ln(1 / k_env_log_start)
+// Below this the exponential curve is snapped to the target
+#define k_env_exp_end (1e-4f)
+
+// Oversampling factors selected by parameter 4
+static const uint8_t k_os_factors[3] = { 1, 2, 4 };
+
+// Per-sample constants of the three curves for the current decay time:
+// 1 / (20 - 20 * pitch_decay) seconds, no decay at all at 1.
+static void update_env(void) {
+    const float rate = 20.0f - (s_state.pitch_decay*20.0f); // 1 / decay time
+    const float x = k_samplerate_recipf * rate; // 1 / decay time in samples
+    s_state.env_step = x;
+    s_state.env_q_ln = k_env_log_ln_range * x;
+}
+
+// Factors of the exponential and log curves per sample for x = 1 / decay
+// time in samples, at the base rate or oversampled. They are close to 1
+// and taken from their series.
+static inline float env_exp_m(const float x) {
+    const float xk = k_env_exp_taus * x;
+    return 1.f - xk * (1.f - 0.5f * xk);
+}
+
+static inline float env_log_m(const float x) {
+    const float xq = k_env_log_ln_range * x;
+    return 1.f + xq * (1.f + 0.5f * xq);
+}
+
 void OSC_INIT(uint32_t platform, uint32_t api) {
     (void)platform;
     (void)api;
     s_state.w_target = 0.f; //target phase delta
     s_state.w_init   = 0.f;
     s_state.w0       = 0.f; //phase delta
-    s_state.phase    = 0.f; //phase
+    s_state.phase    = 0; //phase
     s_state.pitch_decay = 0.f; //pitch decay time
-    s_state.hold_time = 0.f;
-    s_state.dist     = 0.f;
-    s_state.drive    = 0.f;
+    s_state.env = 0.f;
+    s_state.curve = k_curve_lin;
+    s_state.os = 1;
+    update_env();
+    smooth_init(s_state.dist, 0.f);
+    smooth_init(s_state.drive, 0.f);
     s_state.attack_pitch = 0.f;
-    //stores time held: 0-1 -> just pressed-decayed
+    s_state.flags = k_flag_os_reset;
+}
+
+// Quadrature phasor for the phase distortion modulator: z = e^(i 2 pi ph)
+// is rotated by r = e^(i 2 pi w) every sample, 4 multiplies instead of a
+// table lookup. While w moves r is turned by the change of w as well, to
+// second order, which is exact to well below float rounding for the
+// changes the pitch envelope makes. Both are set again from the phase at
+// the start of every render call, so errors only build up over one block.
+// The rounding errors of a moving r add up quadratically in z, so during
+// the pitch envelope the block is cut into k_quad_chirp_block samples.
+#define k_quad_chirp_block (16)
+
+typedef struct Quad {
+    float zc, zs; //modulator phasor
+    float rc, rs; //rotation per sample
+} Quad;
+
+// cos and sin of 2 pi x. The half angle is reduced to [-pi/2, pi/2] and
+// taken from its Taylor series, then doubled: accurate to float rounding,
+// unlike the table whose error would add up in the rotation.
+static inline __attribute__((always_inline)) void quad_sincos(float x, float &c, float &s) {
+    x -= (float)(int32_t)(x + ((x < 0.f) ? -0.5f : 0.5f));
+    const float h = (float)M_PI * x;
+    const float h2 = h * h;
+    const float sh = h * (1.f - h2 * (1.f / 6.f) * (1.f - h2 * (1.f / 20.f) * (1.f - h2 * (1.f / 42.f)
+                          * (1.f - h2 * (1.f / 72.f) * (1.f - h2 * (1.f / 110.f))))));
+    const float ch = 1.f - h2 * 0.5f * (1.f - h2 * (1.f / 12.f) * (1.f - h2 * (1.f / 30.f)
+                          * (1.f - h2 * (1.f / 56.f) * (1.f - h2 * (1.f / 90.f)))));
+    c = 1.f - 2.f * sh * sh;
+    s = 2.f * sh * ch;
+}
+
+static inline __attribute__((always_inline)) void quad_init(Quad &q, const float ph, const float w) {
+    quad_sincos(ph, q.zc, q.zs);
+    quad_sincos(w, q.rc, q.rs);
+}
+
+// Advance by the current w, then turn r by dw = w_next - w
+template <bool chirp>
+static inline __attribute__((always_inline)) void quad_step(Quad &q, const float dw) {
+    const float zc = q.zc * q.rc - q.zs * q.rs;
+    q.zs = q.zs * q.rc + q.zc * q.rs;
+    q.zc = zc;
+    if (chirp) {
+        const float a = (float)M_TWOPI * dw;
+        const float b = 1.f - 0.5f * a * a;
+        const float rc = q.rc * b - q.rs * a;
+        q.rs = q.rs * b + q.rc * a;
+        q.rc = rc;
+    }
+}
+
+// Render one block of the sine into y, drive and the softclip are left to
+// the output stage. The phase increment follows w <- w * m + c every
+// sample while chirp is set, which gives each of the pitch envelope curves
+// (see OSC_CYCLE), and stays put otherwise. The phase is pushed by amt *
+// sin, amt being dist^2 and moving by amt_inc per sample. Phase
+// distortion is a template argument so that the undistorted variant does
+// not pay for the modulating sine.
+template <bool distort, bool chirp>
+static void render(float * __restrict y, const uint32_t frames,
+                   float &w0, const float m, const float c,
+                   float &amt, const float amt_inc,
+                   float &phase) {
+    float ph = phase;
+    float w = w0;
+    float a = amt;
+#if OSC808_PD_QUAD
+    Quad q;
+    if (distort) {
+        quad_init(q, ph, w);
+    }
+#endif
+    const float * y_e = y + frames; // pointer to end of buffer
+    for (; y != y_e; ) { // Time to fill the buffer!
+
+        float p = ph;
+        if (distort) {
+            // Phase distortion
+#if OSC808_PD_QUAD
+            const float mod = q.zs;
+#else
+            const float mod = osc_sinf(ph);
+#endif
+            p = ph + a * mod;
+            p = (p <= 0) ? 1.f - p : p - (uint32_t)p;
+            a += amt_inc;
+        }
+
+        *(y++) = osc_sinf(p);
+
+        ph += w;
+        ph -= (uint32_t)ph;
+        const float w_next = chirp ? w * m + c : w;
+#if OSC808_PD_QUAD
+        if (distort) {
+            quad_step<chirp>(q, w_next - w);
+        }
+#endif
+        w = w_next;
+    }
+    phase = ph;
+    w0 = w;
+    amt += amt_inc * frames;
+}
+
+// Same on a 32-bit phase. The distortion offset amt * sin stays within
+// +/-0.49 of a cycle, so it is added as a signed fraction of 2^32. A phase
+// pushed below zero is mirrored (1 - p in the float version) rather than
+// wrapped. w stays below 0.5, see OSC_CYCLE, so the increment converts
+// without wrapping.
+template <bool distort, bool chirp>
+static void render(float * __restrict y, const uint32_t frames,
+                   float &w0, const float m, const float c,
+                   float &amt, const float amt_inc,
+                   uint32_t &phase) {
+    float a = amt * PHASE_Q32_ONE;
+    const float a_inc = amt_inc * PHASE_Q32_ONE;
+    uint32_t ph = phase;
+    float w = w0;
+#if OSC808_PD_QUAD
+    Quad q;
+    if (distort) {
+        quad_init(q, phase_q32_to_f32(ph), w);
+    }
+#endif
+    const float * y_e = y + frames; // pointer to end of buffer
+    for (; y != y_e; ) {
+
+        uint32_t p = ph;
+        if (distort) {
+#if OSC808_PD_QUAD
+            const float mod = q.zs;
+#else
+            const float mod = phase_q32_sinf(ph);
+#endif
+            const int32_t d = (int32_t)(a * mod);
+            p = ph + d;
+            p = (d < 0 && p > ph) ? -p : p;
+            a += a_inc;
+        }
+
+        *(y++) = phase_q32_sinf(p);
+
+        ph += (uint32_t)(w * PHASE_Q32_ONE);
+        const float w_next = chirp ? w * m + c : w;
+#if OSC808_PD_QUAD
+        if (distort) {
+            quad_step<chirp>(q, w_next - w);
+        }
+#endif
+        w = w_next;
+    }
+    phase = ph;
+    w0 = w;
+    amt += amt_inc * frames;
+}
+
+// Pick the kernel for the block, m = 1 and c = 0 hold the pitch
+static inline void render_block(float * __restrict y, const uint32_t frames,
+                                float &w0, const float m, const float c,
+                                float &amt, const float amt_inc,
+                                phase_t &phase) {
+    const bool chirp = (m != 1.f || c != 0.f);
+    if (amt > 0.f || amt_inc != 0.f) {
+        if (chirp) {
+            for (uint32_t done = 0; done < frames; done += k_quad_chirp_block) {
+                const uint32_t n = (frames - done < k_quad_chirp_block) ? frames - done : k_quad_chirp_block;
+                render<true, true>(y + done, n, w0, m, c, amt, amt_inc, phase);
+            }
+        } else {
+            render<true, false>(y, frames, w0, m, c, amt, amt_inc, phase);
+        }
+    } else {
+        if (chirp) {
+            render<false, true>(y, frames, w0, m, c, amt, amt_inc, phase);
+        } else {
+            render<false, false>(y, frames, w0, m, c, amt, amt_inc, phase);
+        }
+    }
 }
 
 // params: oscillator parameter
@@ -53,43 +316,158 @@ void OSC_CYCLE(const user_osc_param_t * const params,
     s_state.flags = k_flags_none;
 
     const float attack_pitch = s_state.attack_pitch;
-    // Get the target phase delta (where we want to end up)
-    const float w_target = s_state.w_target = osc_w0f_for_note((params->pitch)>>8, params->pitch & 0xFF) / 2.f;
-    const float w_init = s_state.w_init = osc_w0f_for_note((params->pitch)>>8, params->pitch & 0xFF) * attack_pitch;
-    const float pitch_decay = s_state.pitch_decay;
-    float hold_time = s_state.hold_time;
+    // Get the target phase delta (where we want to end up). The start is
+    // kept below Nyquist.
+    const float w_note = osc_w0f_for_note((params->pitch)>>8, params->pitch & 0xFF);
+    const float w_target = s_state.w_target = w_note / 2.f;
+    float w_init = w_note * attack_pitch;
+    w_init = s_state.w_init = (w_init < 0.49f) ? w_init : 0.49f;
+    const float span = w_init - w_target;
+
+    // The phase distortion and the drive run os times faster, w and the
+    // envelope constants below are per oversampled step
+    const uint32_t os = s_state.os;
+    const float os_recip = 1.f / os;
+    const float x = s_state.env_step * os_recip;
 
-    const float w0 = s_state.w0 = linintf(hold_time,w_init,w_target);
-    float phase = (flags & k_flag_reset) ? 0.f : s_state.phase;
+    // The envelope runs on w itself, w <- w * m + c per sample, until
+    // `ramp` samples from now, then w stays at w_target:
+    //  linear: w drops by span * env_step per sample
+    //  exponential: the distance to w_target is scaled by env_exp_m()
+    //  log: the distance to w_init grows by env_log_m()
+    float env = (flags & k_flag_reset) ? 1.f : s_state.env;
+    float m = 1.f;
+    float c = 0.f;
+    uint32_t ramp = 0;
+    if (env > 0.f && s_state.pitch_decay < 1.f) {
+        switch (s_state.curve) {
+            case k_curve_exp:
+                m = env_exp_m(x);
+                c = w_target * os_recip * (1.f - m);
+                ramp = frames;
+                break;
+            case k_curve_log: {
+                env = (env < 1.f - k_env_log_start) ? env : 1.f - k_env_log_start;
+                m = env_log_m(x);
+                c = w_init * os_recip * (1.f - m);
+                const float left = -fastlogf(1.f - env) / s_state.env_q_ln;
+                ramp = (left < frames) ? (uint32_t)left : frames;
+                break;
+            }
+            default: {
+                c = -span * os_recip * x;
+                const float left = env / s_state.env_step;
+                ramp = (left < frames) ? (uint32_t)left : frames;
+                break;
+            }
+        }
+    } else if (s_state.pitch_decay >= 1.f) {
+        ramp = frames; // held at w_init + span * env with m = 1
+    }
+    float w0 = (w_target + span * env) * os_recip;
+    phase_t phase = (flags & k_flag_reset) ? 0 : s_state.phase;
 
-    // phase distortion
-    const float dist  = s_state.dist;
-    const float drive = s_state.drive;
+    // A moving drive is ramped into the block ahead of the softclip, which
+    // then runs at a gain of 1
+    float drive;
+    const float drive_inc = smooth_block(s_state.drive, frames, drive);
 
-    // lfo stuf
+    // The shape LFO moves the phase distortion. It comes once per block
+    // and is followed from the last value, the depth is computed every
+    // OSC808_LFO_RATE frames and its square ramped in between. The dist
+    // parameter ramps to a new value along with it. A still LFO and a
+    // settled dist leave one ramp of 0 for the whole block.
     const float lfo = s_state.lfo = q31_to_f32(params->shape_lfo);
     float lfoz = (flags & k_flag_reset) ? lfo : s_state.lfoz;
     const float lfo_inc = (lfo - lfoz) / frames;
+    float dist;
+    const float dist_inc = smooth_block(s_state.dist, frames, dist);
+    const uint32_t rate = (lfo_inc != 0.f || dist_inc != 0.f) ? OSC808_LFO_RATE : frames;
+    float amt = clipminmaxf(0.f, dist + 0.7f * lfoz, 0.7f);
+    amt *= amt;
 
-    q31_t * __restrict y = (q31_t *)yn; // pointer to current buffer position
-    const q31_t * y_e = y + frames; // pointer to end of buffer
-    for (; y != y_e; ) { // Time to fill the buffer!
-
-        // Phase distortion
-        float p = phase + linintf(dist, 0.f, dist * osc_sinf(phase));
-        p = (p <= 0) ? 1.f - p : p - (uint32_t)p;
-
-        const float sig = osc_softclipf(0.05f,drive * osc_sinf(p));
-        *(y++) = f32_to_q31(sig);
+    // Oversampled, the sine is rendered into ov1 (4x) or ov2 (2x) after
+    // the end of the previous input of the decimators, softclipped there
+    // and decimated down to buf, k_output_block oversampled frames at a
+    // time. The decimators restart from silence when the factor changes.
+    const uint32_t hist1 = halfband_hist(3);
+    const uint32_t hist2 = halfband_hist(5);
+    float ov1[hist1 + k_output_block];
+    float ov2[hist2 + k_output_block];
+    if (flags & k_flag_os_reset) {
+        for (uint32_t i = 0; i < hist1; i++) {
+            s_state.os_hist1[i] = 0.f;
+        }
+        for (uint32_t i = 0; i < hist2; i++) {
+            s_state.os_hist2[i] = 0.f;
+        }
+    }
+    if (os > 1) {
+        for (uint32_t i = 0; i < hist1; i++) {
+            ov1[i] = s_state.os_hist1[i];
+        }
+        for (uint32_t i = 0; i < hist2; i++) {
+            ov2[i] = s_state.os_hist2[i];
+        }
+    }
 
-        phase += w0;
-        phase -= (uint32_t)phase;
-        hold_time += k_samplerate_recipf * (20.0f - (pitch_decay*20.0f));
-        hold_time = clip1f(hold_time);
+    // The envelope is done after `ramp` samples, the rest of the block is
+    // rendered at w_target.
+    const uint32_t block = k_output_block / os;
+    float buf[k_output_block] __attribute__((aligned(16)));
+    float * const x_os = (os == 4) ? ov1 + hist1 : (os == 2) ? ov2 + hist2 : buf;
+    q31_t * __restrict y = (q31_t *)yn;
+    for (uint32_t done = 0; done < frames; done += block) {
+        const uint32_t n = (frames - done < block) ? frames - done : block;
+        for (uint32_t seg = 0; seg < n; seg += rate) {
+            const uint32_t t = done + seg;
+            const uint32_t ns = (n - seg < rate) ? n - seg : rate;
+            float amt_end = clipminmaxf(0.f, dist + dist_inc * (t + ns) + 0.7f * (lfoz + lfo_inc * (t + ns)), 0.7f);
+            amt_end *= amt_end;
+            const float amt_inc = (amt_end - amt) / (ns * os);
+            const uint32_t n_env = (ramp <= t) ? 0 : (ramp - t < ns) ? ramp - t : ns;
+            float * const xs = x_os + seg * os;
+            render_block(xs, n_env * os, w0, m, c, amt, amt_inc, phase);
+            if (n_env < ns) {
+                w0 = w_target * os_recip;
+                render_block(xs + n_env * os, (ns - n_env) * os, w0, 1.f, 0.f, amt, amt_inc, phase);
+            }
+            amt = amt_end;
+        }
+        float g = drive;
+        if (drive_inc != 0.f) {
+            smooth_ramp(x_os, n * os, drive + drive_inc * done, drive_inc * os_recip);
+            g = 1.f;
+        }
+        if (os == 1) {
+            output_softclip_q31(y + done, buf, n, g);
+        } else {
+            output_softclip(x_os, n * os, g);
+            if (os == 4) {
+                halfband_decimate(ov2 + hist2, ov1 + hist1, 2 * n, k_halfband_11);
+            }
+            halfband_decimate(buf, ov2 + hist2, n, k_halfband_19);
+            output_q31(y + done, buf, n);
+        }
+    }
+    if (os > 1) {
+        for (uint32_t i = 0; i < hist1; i++) {
+            s_state.os_hist1[i] = ov1[i];
+        }
+        for (uint32_t i = 0; i < hist2; i++) {
+            s_state.os_hist2[i] = ov2[i];
+        }
+    }
 
-        lfoz += lfo_inc;
+    // Back to the envelope state, pitch may change by the next block
+    w0 *= os;
+    env = (ramp == frames && span != 0.f) ? (w0 - w_target) / span : 0.f;
+    if (s_state.curve == k_curve_exp && env < k_env_exp_end) {
+        env = 0.f;
     }
-    s_state.hold_time = hold_time;
+    s_state.env = env;
+    s_state.w0 = w0;
+    lfoz += lfo_inc * frames;
     s_state.phase = phase;
     s_state.lfoz = lfoz;
 }
@@ -97,7 +475,6 @@ void OSC_CYCLE(const user_osc_param_t * const params,
 void OSC_NOTEON(const user_osc_param_t * const params) {
     //Reset the flag
     s_state.flags |= k_flag_reset;
-    s_state.hold_time = 0.f;
 }
 
 void OSC_NOTEOFF(const user_osc_param_t * const params) {
@@ -109,21 +486,31 @@ void OSC_PARAM(uint16_t index, uint16_t value) {
 
     switch (index) {
         case k_user_osc_param_id1:
-            s_state.drive = 1.f + valf;
+            smooth_set(s_state.drive, 1.f + valf);
             break;
         case k_user_osc_param_id2:
             s_state.attack_pitch = 1.f + (valf * 24.f);
             break;
         case k_user_osc_param_id3:
-        case k_user_osc_param_id4:
+            s_state.curve = (value < k_num_curves) ? value : (uint16_t)k_curve_lin;
+            break;
+        case k_user_osc_param_id4: {
+            const uint8_t os = k_os_factors[(value < 3) ? value : 0];
+            if (os != s_state.os) {
+                s_state.os = os;
+                s_state.flags |= k_flag_os_reset;
+            }
+            break;
+        }
         case k_user_osc_param_id5:
         case k_user_osc_param_id6:
             break;
         case k_user_osc_param_shape:
             s_state.pitch_decay = valf;
+            update_env();
             break;
         case k_user_osc_param_shiftshape:
-            s_state.dist = 0.7f * valf;
+            smooth_set(s_state.dist, 0.7f * valf);
             break;
         default:
             break;
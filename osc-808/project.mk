@@ -8,7 +8,7 @@ UCSRC =
 
 UCXXSRC = 808-osc.cpp
 
-UINCDIR =
+UINCDIR = ../common
 
 UDEFS =
 